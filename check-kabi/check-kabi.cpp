@@ -0,0 +1,908 @@
+/*
+ *  check-kabi - Checks the kABI compatibility of kmod packages
+ *
+ *  Native replacement for check-kabi.sh. Module.symvers is parsed once
+ *  into a symbol -> CRC hash table and the kernel(...) requires are read
+ *  straight from the header of every kmod RPM, all packages in parallel.
+ *  The output and the error count are the same as the script.
+ *
+ *  In matrix mode many Module.symvers files are loaded at once. Symbol
+ *  names are interned once across all kernels, each kernel only keeps a
+ *  CRC array indexed by symbol id, and every package is checked against
+ *  every kernel in a single pass.
+ *
+ *  In forecast mode two Module.symvers files are sorted and merged to find
+ *  the changed and removed symbols, which are then looked up in a reverse
+ *  index of symbol -> kmod packages to rank the packages that will break.
+ *
+ *  Copyright (C) 2026 The ELRepo Project <https://elrepo.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "rpmheader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <glob.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+extern char *optarg;
+extern int optind, opterr, optopt;
+
+
+// kernel symbol requires look like "kernel(symbol) = 0x1234abcd"
+const string KSYM_PREFIX("kernel(");
+const string KSYM_SUFFIX(")");
+
+
+// symbol id used for requires of symbols that no kernel exports
+const uint32_t NO_SYMBOL = UINT32_MAX;
+
+
+// symbol names shared by all kernels, the deque keeps the names at stable addresses
+typedef struct
+{
+    deque<string> names;
+    unordered_map<string_view, uint32_t> ids;
+} symbol_table_t;
+
+
+// one kernel, crcs[] and present[] are indexed by symbol id
+typedef struct
+{
+    string name;
+    vector<uint32_t> crcs;
+    vector<bool> present;
+} kernel_symvers_t;
+
+
+// one kernel symbol require of a package
+typedef struct
+{
+    string symbol;
+    uint32_t crc;
+    string line;
+} ksym_require_t;
+
+
+// per package result, filled in by the worker threads
+// failed[] lists the failing requires per kernel
+typedef struct
+{
+    string file;
+    bool readable;
+    vector<vector<string>> failed;
+} kmod_result_t;
+
+
+// a symbol whose CRC changed or that was removed between two kernels
+typedef struct
+{
+    string symbol;
+    uint32_t old_crc;
+    uint32_t new_crc;
+    bool removed;
+} symbol_change_t;
+
+
+// a package affected by the symbol changes
+typedef struct
+{
+    string file;
+    vector<const symbol_change_t*> changes;
+} kmod_forecast_t;
+
+
+// function prototypes
+void print_usage(char* progname);
+vector<string> find_kmod_packages(string const& dir);
+string kernel_name_from_path(string const& path);
+vector<string> find_installed_symvers();
+uint32_t intern_symbol(symbol_table_t& symbols, string_view name);
+uint32_t lookup_symbol(symbol_table_t const& symbols, string const& name);
+bool load_symvers(string const& path, symbol_table_t& symbols, kernel_symvers_t& kernel);
+bool parse_ksym_require(string const& line, ksym_require_t& ksym);
+vector<ksym_require_t> read_ksym_requires(string const& path, bool& readable);
+void check_packages(symbol_table_t const& symbols, vector<kernel_symvers_t> const& kernels,
+                    vector<kmod_result_t>& results, unsigned int jobs);
+int print_report(vector<kmod_result_t> const& results);
+int print_matrix(vector<kernel_symvers_t> const& kernels, vector<kmod_result_t> const& results);
+bool read_sorted_symvers(string const& path, vector<pair<string, uint32_t>>& syms);
+vector<symbol_change_t> diff_symvers(vector<pair<string, uint32_t>> const& old_syms,
+                                     vector<pair<string, uint32_t>> const& new_syms);
+unordered_map<string, vector<pair<uint32_t, uint32_t>>> build_reverse_index(vector<string> const& kmods, unsigned int jobs);
+int forecast(string const& old_file, string const& new_file, vector<string> const& kmods, unsigned int jobs);
+
+
+/*
+ * Main program
+ */
+int main(int argc, char** argv)
+{
+    char* prog_name = argv[0];
+    string kversion;
+    vector<string> symvers_files;
+    string kmod_dir = ".";
+    unsigned int jobs = thread::hardware_concurrency();
+    int matrix = 0;
+    int forecast_mode = 0;
+
+    const char* const optstring = "k:s:j:mfh";
+    const option longopts[] =
+    {
+        {"kernel", required_argument, nullptr, 'k'},
+        {"symvers", required_argument, nullptr, 's'},
+        {"jobs", required_argument, nullptr, 'j'},
+        {"matrix", no_argument, nullptr, 'm'},
+        {"forecast", no_argument, nullptr, 'f'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, no_argument, nullptr, 0}
+    };
+    int longindex = 0;
+
+    while (true)
+    {
+        int c = getopt_long(argc, argv, optstring, longopts, &longindex);
+
+        if (c == -1)
+        {
+            break;
+        }
+
+        switch (c)
+        {
+            case 'k':
+                kversion = optarg;
+                break;
+
+            case 's':
+                symvers_files.push_back(optarg);
+                break;
+
+            case 'm':
+                matrix = 1;
+                break;
+
+            case 'f':
+                forecast_mode = 1;
+                break;
+
+            case 'j':
+                jobs = atoi(optarg);
+                break;
+
+            case 'h': // -h or --help
+            case '?': // Unrecognized option
+            default:
+                print_usage(prog_name);
+                return EXIT_FAILURE;
+        }
+    }
+
+    // non-option arguments
+    if (optind < argc)
+    {
+        kmod_dir = argv[optind];
+    }
+
+    if (jobs == 0)
+    {
+        jobs = 1;
+    }
+
+    if (forecast_mode)
+    {
+        if (symvers_files.size() != 2)
+        {
+            cerr << "Forecast mode needs exactly two -s files: the old and the new Module.symvers" << endl;
+            print_usage(prog_name);
+            return EXIT_FAILURE;
+        }
+    }
+    else if (matrix)
+    {
+        // default to every installed kernel-devel
+        if (symvers_files.empty())
+        {
+            symvers_files = find_installed_symvers();
+        }
+    }
+    else
+    {
+        if (symvers_files.size() > 1)
+        {
+            cerr << "More than one -s file needs --matrix or --forecast" << endl;
+            print_usage(prog_name);
+            return EXIT_FAILURE;
+        }
+
+        if (!symvers_files.empty())
+        {
+            // without -k, name the kernel after the given Module.symvers
+            if (kversion.empty())
+            {
+                kversion = kernel_name_from_path(symvers_files[0]);
+            }
+        }
+        else
+        {
+            // default to the running kernel
+            if (kversion.empty())
+            {
+                struct utsname uts;
+                uname(&uts);
+                kversion = uts.release;
+            }
+
+            symvers_files.push_back("/usr/src/kernels/" + kversion + "/Module.symvers");
+        }
+    }
+
+    vector<string> kmods = find_kmod_packages(kmod_dir);
+
+    if (kmods.empty())
+    {
+        cout << "No kmod packages found to test" << endl;
+        return EXIT_FAILURE;
+    }
+
+    if (forecast_mode)
+    {
+        return forecast(symvers_files[0], symvers_files[1], kmods, jobs);
+    }
+
+    if (!matrix)
+    {
+        cout << "kmod packages found - running kABI compatibility tests with kernel-" << kversion << endl;
+    }
+
+    symbol_table_t symbols;
+    vector<kernel_symvers_t> kernels(symvers_files.size());
+
+    for (size_t k = 0; k < symvers_files.size(); k++)
+    {
+        if (!load_symvers(symvers_files[k], symbols, kernels[k]))
+        {
+            cerr << "Error opening Module.symvers file: " << symvers_files[k] << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (kernels.empty())
+    {
+        cerr << "No Module.symvers files found" << endl;
+        return EXIT_FAILURE;
+    }
+
+    vector<kmod_result_t> results(kmods.size());
+
+    for (size_t i = 0; i < kmods.size(); i++)
+    {
+        results[i].file = kmods[i];
+    }
+
+    check_packages(symbols, kernels, results, jobs);
+
+    if (matrix)
+    {
+        print_matrix(kernels, results);
+    }
+    else
+    {
+        print_report(results);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+
+// functions
+void print_usage(char* progname)
+{
+    cerr << "Usage: " << progname << " [options] [kmod-dir]" << endl
+         << "-k,--kernel <version>  :  kernel version (default running kernel)" << endl
+         << "-s,--symvers <file>    :  Module.symvers file (default /usr/src/kernels/<version>/Module.symvers)" << endl
+         << "                          repeat in matrix mode to check against several kernels" << endl
+         << "-m,--matrix            :  print a package x kernel pass/fail matrix" << endl
+         << "                          (default all /usr/src/kernels/*/Module.symvers)" << endl
+         << "-f,--forecast          :  rank the packages broken by moving from the first -s file" << endl
+         << "                          to the second -s file" << endl
+         << "-j,--jobs <n>          :  number of packages checked in parallel (default all cores)" << endl
+         << "-h,--help              :  show help" << endl
+         << endl;
+}
+
+
+// prints the failing requires of every package, same as the script
+int print_report(vector<kmod_result_t> const& results)
+{
+    int errors = 0;
+
+    for (auto const& result : results)
+    {
+        if (!result.readable)
+        {
+            cerr << "Error reading package: " << result.file << endl;
+            continue;
+        }
+
+        if (!result.failed[0].empty())
+        {
+            cout << endl << "Package " << result.file << " failed kABI check" << endl;
+
+            for (auto const& line : result.failed[0])
+            {
+                cout << line << endl;
+            }
+
+            errors += result.failed[0].size();
+        }
+    }
+
+    cout << endl << "Total number of errors: " << errors << endl;
+
+    return errors;
+}
+
+
+// prints one row per package and one column per kernel
+int print_matrix(vector<kernel_symvers_t> const& kernels, vector<kmod_result_t> const& results)
+{
+    int errors = 0;
+    size_t name_width = 7;
+
+    for (auto const& result : results)
+    {
+        name_width = max(name_width, result.file.size());
+    }
+
+    cout << "Kernels:" << endl;
+
+    for (size_t k = 0; k < kernels.size(); k++)
+    {
+        cout << "  [" << k + 1 << "] " << kernels[k].name << endl;
+    }
+
+    cout << endl << left << setw(name_width) << "Package";
+
+    for (size_t k = 0; k < kernels.size(); k++)
+    {
+        cout << "  " << setw(9) << "[" + to_string(k + 1) + "]";
+    }
+
+    cout << endl;
+
+    for (auto const& result : results)
+    {
+        cout << setw(name_width) << result.file;
+
+        for (size_t k = 0; k < kernels.size(); k++)
+        {
+            string cell;
+
+            if (!result.readable)
+            {
+                cell = "ERROR";
+            }
+            else if (result.failed[k].empty())
+            {
+                cell = "pass";
+            }
+            else
+            {
+                cell = "FAIL(" + to_string(result.failed[k].size()) + ")";
+                errors += result.failed[k].size();
+            }
+
+            cout << "  " << setw(9) << cell;
+        }
+
+        cout << endl;
+    }
+
+    cout << endl << "Total number of errors: " << errors << endl;
+
+    return errors;
+}
+
+
+// lists kmod-*.rpm in a directory, sorted like 'ls'
+vector<string> find_kmod_packages(string const& dir)
+{
+    vector<string> kmods;
+    DIR* d = opendir(dir.c_str());
+
+    if (d == nullptr)
+    {
+        return kmods;
+    }
+
+    struct dirent* entry;
+
+    while ((entry = readdir(d)) != nullptr)
+    {
+        string name = entry->d_name;
+
+        if (name.compare(0, 5, "kmod-") == 0 && name.size() > 9
+            && name.compare(name.size() - 4, 4, ".rpm") == 0)
+        {
+            kmods.push_back(dir == "." ? name : dir + "/" + name);
+        }
+    }
+
+    closedir(d);
+    sort(kmods.begin(), kmods.end());
+
+    return kmods;
+}
+
+
+// names a kernel after the directory holding its Module.symvers
+string kernel_name_from_path(string const& path)
+{
+    size_t slash = path.rfind('/');
+
+    if (slash == string::npos || slash == 0)
+    {
+        return path;
+    }
+
+    size_t parent = path.rfind('/', slash - 1);
+
+    return path.substr(parent == string::npos ? 0 : parent + 1, slash - (parent == string::npos ? 0 : parent + 1));
+}
+
+
+// lists the Module.symvers files of all installed kernel-devel packages
+vector<string> find_installed_symvers()
+{
+    vector<string> files;
+    glob_t g;
+
+    if (glob("/usr/src/kernels/*/Module.symvers", 0, nullptr, &g) == 0)
+    {
+        files.assign(g.gl_pathv, g.gl_pathv + g.gl_pathc);
+    }
+
+    globfree(&g);
+
+    return files;
+}
+
+
+// returns the id of a symbol name, adding it on first sight
+uint32_t intern_symbol(symbol_table_t& symbols, string_view name)
+{
+    auto iter = symbols.ids.find(name);
+
+    if (iter != symbols.ids.end())
+    {
+        return iter->second;
+    }
+
+    uint32_t id = symbols.names.size();
+    symbols.names.emplace_back(name);
+    symbols.ids.emplace(symbols.names.back(), id);
+
+    return id;
+}
+
+
+// returns the id of a symbol name or NO_SYMBOL if no kernel exports it
+uint32_t lookup_symbol(symbol_table_t const& symbols, string const& name)
+{
+    auto iter = symbols.ids.find(name);
+
+    return iter == symbols.ids.end() ? NO_SYMBOL : iter->second;
+}
+
+
+// maps Module.symvers and records every "<crc>\t<symbol>\t..." line
+bool load_symvers(string const& path, symbol_table_t& symbols, kernel_symvers_t& kernel)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    size_t size = st.st_size;
+    void* data = size ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : nullptr;
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        return false;
+    }
+
+    kernel.name = kernel_name_from_path(path);
+    symbols.ids.reserve(size / 64);
+
+    const char* p   = (const char*)data;
+    const char* end = p + size;
+
+    while (p < end)
+    {
+        const char* eol = (const char*)memchr(p, '\n', end - p);
+
+        if (eol == nullptr)
+        {
+            eol = end;
+        }
+
+        const char* tab1 = (const char*)memchr(p, '\t', eol - p);
+
+        if (tab1 != nullptr)
+        {
+            const char* sym = tab1 + 1;
+            const char* tab2 = (const char*)memchr(sym, '\t', eol - sym);
+
+            if (tab2 == nullptr)
+            {
+                tab2 = eol;
+            }
+
+            uint32_t id = intern_symbol(symbols, string_view(sym, tab2 - sym));
+
+            if (id >= kernel.crcs.size())
+            {
+                kernel.crcs.resize(max<size_t>(id + 1, symbols.names.size()));
+                kernel.present.resize(kernel.crcs.size());
+            }
+
+            kernel.crcs[id] = strtoul(p, nullptr, 16);
+            kernel.present[id] = true;
+        }
+
+        p = eol + 1;
+    }
+
+    if (data != nullptr)
+    {
+        munmap(data, size);
+    }
+
+    kernel.crcs.shrink_to_fit();
+
+    return true;
+}
+
+
+// splits "kernel(symbol) = 0x1234abcd", returns false for other requires
+bool parse_ksym_require(string const& line, ksym_require_t& ksym)
+{
+    if (line.compare(0, KSYM_PREFIX.size(), KSYM_PREFIX) != 0)
+    {
+        return false;
+    }
+
+    size_t close_paren = line.find(KSYM_SUFFIX + " ");
+    size_t eq = line.find("= ");
+
+    if (close_paren == string::npos || eq == string::npos)
+    {
+        return false;
+    }
+
+    ksym.symbol = line.substr(KSYM_PREFIX.size(), close_paren - KSYM_PREFIX.size());
+    ksym.crc = strtoul(line.c_str() + eq + 2, nullptr, 16);
+    ksym.line = line;
+
+    return true;
+}
+
+
+// reads the kernel symbol requires straight from the package header
+vector<ksym_require_t> read_ksym_requires(string const& path, bool& readable)
+{
+    vector<ksym_require_t> ksyms;
+    rpm_package_t pkg;
+
+    readable = rpm_read_package(path, pkg);
+
+    if (!readable)
+    {
+        return ksyms;
+    }
+
+    for (auto const& line : rpm_get_requires(pkg.header))
+    {
+        ksym_require_t ksym;
+
+        if (parse_ksym_require(line, ksym))
+        {
+            ksyms.push_back(ksym);
+        }
+    }
+
+    return ksyms;
+}
+
+
+// checks all packages against all kernels, each worker thread takes the next unchecked package
+void check_packages(symbol_table_t const& symbols, vector<kernel_symvers_t> const& kernels,
+                    vector<kmod_result_t>& results, unsigned int jobs)
+{
+    atomic<size_t> next(0);
+
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < results.size(); i = next++)
+        {
+            results[i].failed.resize(kernels.size());
+
+            for (auto const& ksym : read_ksym_requires(results[i].file, results[i].readable))
+            {
+                // resolve the name once, then every kernel is an array lookup
+                uint32_t id = lookup_symbol(symbols, ksym.symbol);
+
+                for (size_t k = 0; k < kernels.size(); k++)
+                {
+                    kernel_symvers_t const& kernel = kernels[k];
+
+                    if (id >= kernel.crcs.size() || !kernel.present[id] || kernel.crcs[id] != ksym.crc)
+                    {
+                        results[i].failed[k].push_back(ksym.line);
+                    }
+                }
+            }
+        }
+    };
+
+    vector<thread> threads;
+    jobs = min<size_t>(jobs, results.size());
+
+    for (unsigned int t = 1; t < jobs; t++)
+    {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+}
+
+
+// reads "<crc>\t<symbol>\t..." lines and sorts them by symbol name
+bool read_sorted_symvers(string const& path, vector<pair<string, uint32_t>>& syms)
+{
+    ifstream fin(path);
+    string line;
+
+    if (!fin)
+    {
+        return false;
+    }
+
+    while (getline(fin, line))
+    {
+        size_t tab1 = line.find('\t');
+
+        if (tab1 == string::npos)
+        {
+            continue;
+        }
+
+        size_t tab2 = line.find('\t', tab1 + 1);
+        syms.emplace_back(line.substr(tab1 + 1, tab2 == string::npos ? string::npos : tab2 - tab1 - 1),
+                          strtoul(line.c_str(), nullptr, 16));
+    }
+
+    sort(syms.begin(), syms.end());
+
+    return true;
+}
+
+
+// merges two sorted symbol lists into the changed and removed symbols
+vector<symbol_change_t> diff_symvers(vector<pair<string, uint32_t>> const& old_syms,
+                                     vector<pair<string, uint32_t>> const& new_syms)
+{
+    vector<symbol_change_t> changes;
+    auto o = old_syms.begin();
+    auto n = new_syms.begin();
+
+    while (o != old_syms.end())
+    {
+        if (n == new_syms.end() || o->first < n->first)
+        {
+            changes.push_back({o->first, o->second, 0, true});
+            o++;
+        }
+        else if (n->first < o->first)
+        {
+            // added symbols cannot break existing packages
+            n++;
+        }
+        else
+        {
+            if (o->second != n->second)
+            {
+                changes.push_back({o->first, o->second, n->second, false});
+            }
+
+            o++;
+            n++;
+        }
+    }
+
+    return changes;
+}
+
+
+// maps every required kernel symbol to the packages requiring it and the crc they require
+unordered_map<string, vector<pair<uint32_t, uint32_t>>> build_reverse_index(vector<string> const& kmods, unsigned int jobs)
+{
+    vector<vector<ksym_require_t>> requires_list(kmods.size());
+    atomic<size_t> next(0);
+
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < kmods.size(); i = next++)
+        {
+            bool readable;
+            requires_list[i] = read_ksym_requires(kmods[i], readable);
+
+            if (!readable)
+            {
+                cerr << "Error reading package: " << kmods[i] << endl;
+            }
+        }
+    };
+
+    vector<thread> threads;
+    jobs = min<size_t>(jobs, kmods.size());
+
+    for (unsigned int t = 1; t < jobs; t++)
+    {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    unordered_map<string, vector<pair<uint32_t, uint32_t>>> index;
+
+    for (uint32_t i = 0; i < kmods.size(); i++)
+    {
+        for (auto const& ksym : requires_list[i])
+        {
+            index[ksym.symbol].push_back({i, ksym.crc});
+        }
+    }
+
+    return index;
+}
+
+
+// prints the packages affected by the symbol changes, most affected first
+int forecast(string const& old_file, string const& new_file, vector<string> const& kmods, unsigned int jobs)
+{
+    vector<pair<string, uint32_t>> old_syms, new_syms;
+
+    if (!read_sorted_symvers(old_file, old_syms))
+    {
+        cerr << "Error opening Module.symvers file: " << old_file << endl;
+        return EXIT_FAILURE;
+    }
+
+    if (!read_sorted_symvers(new_file, new_syms))
+    {
+        cerr << "Error opening Module.symvers file: " << new_file << endl;
+        return EXIT_FAILURE;
+    }
+
+    vector<symbol_change_t> changes = diff_symvers(old_syms, new_syms);
+    unordered_map<string, vector<pair<uint32_t, uint32_t>>> index = build_reverse_index(kmods, jobs);
+
+    // intersect the changes with the reverse index
+    vector<kmod_forecast_t> affected(kmods.size());
+    size_t removed = 0;
+
+    for (auto const& change : changes)
+    {
+        removed += change.removed;
+        auto iter = index.find(change.symbol);
+
+        if (iter == index.end())
+        {
+            continue;
+        }
+
+        for (auto const& entry : iter->second)
+        {
+            // packages already built against the new crc are not affected
+            if (!change.removed && entry.second == change.new_crc)
+            {
+                continue;
+            }
+
+            affected[entry.first].file = kmods[entry.first];
+            affected[entry.first].changes.push_back(&change);
+        }
+    }
+
+    affected.erase(remove_if(affected.begin(), affected.end(),
+                             [](kmod_forecast_t const& a) { return a.changes.empty(); }),
+                   affected.end());
+
+    stable_sort(affected.begin(), affected.end(),
+                [](kmod_forecast_t const& a, kmod_forecast_t const& b)
+                { return a.changes.size() > b.changes.size(); });
+
+    cout << "kABI forecast from kernel-" << kernel_name_from_path(old_file)
+         << " to kernel-" << kernel_name_from_path(new_file) << endl
+         << "Changed symbols: " << changes.size() - removed << ", removed symbols: " << removed << endl;
+
+    char crcs[32];
+
+    for (auto const& a : affected)
+    {
+        cout << endl << "Package " << a.file << " will fail kABI check (" << a.changes.size() << " symbols)" << endl;
+
+        for (auto const* change : a.changes)
+        {
+            if (change->removed)
+            {
+                cout << "kernel(" << change->symbol << ") removed" << endl;
+            }
+            else
+            {
+                snprintf(crcs, sizeof(crcs), "0x%08x -> 0x%08x", change->old_crc, change->new_crc);
+                cout << "kernel(" << change->symbol << ") changed " << crcs << endl;
+            }
+        }
+    }
+
+    cout << endl << "Total number of affected packages: " << affected.size() << endl;
+
+    return EXIT_SUCCESS;
+}
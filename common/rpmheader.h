@@ -0,0 +1,450 @@
+/*
+ *  rpmheader.h - Minimal reader for the header section of RPM package files
+ *
+ *  Only the lead, the signature header and the main header are read, the
+ *  payload is never touched. This is enough to query the same tags that
+ *  'rpm -qp' prints, without librpm and without spawning a process.
+ *
+ *  Copyright (C) 2026 The ELRepo Project <https://elrepo.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _RPMHEADER_H
+#define _RPMHEADER_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+
+// sizes and magic numbers of the on-disk format
+const size_t RPM_LEAD_SIZE = 96;
+const unsigned char RPM_LEAD_MAGIC[4] = {0xED, 0xAB, 0xEE, 0xDB};
+const unsigned char RPM_HEADER_MAGIC[4] = {0x8E, 0xAD, 0xE8, 0x01};
+const uint32_t RPM_HEADER_MAX_SIZE = 256 * 1024 * 1024;
+
+
+// tag data types
+typedef enum
+{
+    RPM_TYPE_NULL         = 0,
+    RPM_TYPE_CHAR         = 1,
+    RPM_TYPE_INT8         = 2,
+    RPM_TYPE_INT16        = 3,
+    RPM_TYPE_INT32        = 4,
+    RPM_TYPE_INT64        = 5,
+    RPM_TYPE_STRING       = 6,
+    RPM_TYPE_BIN          = 7,
+    RPM_TYPE_STRING_ARRAY = 8,
+    RPM_TYPE_I18NSTRING   = 9
+} rpm_type_t;
+
+
+// main header tags
+const uint32_t RPMTAG_NAME            = 1000;
+const uint32_t RPMTAG_VERSION         = 1001;
+const uint32_t RPMTAG_RELEASE         = 1002;
+const uint32_t RPMTAG_EPOCH           = 1003;
+const uint32_t RPMTAG_SUMMARY         = 1004;
+const uint32_t RPMTAG_DESCRIPTION     = 1005;
+const uint32_t RPMTAG_BUILDTIME       = 1006;
+const uint32_t RPMTAG_BUILDHOST       = 1007;
+const uint32_t RPMTAG_SIZE            = 1009;
+const uint32_t RPMTAG_VENDOR          = 1011;
+const uint32_t RPMTAG_LICENSE         = 1014;
+const uint32_t RPMTAG_PACKAGER        = 1015;
+const uint32_t RPMTAG_GROUP           = 1016;
+const uint32_t RPMTAG_URL             = 1020;
+const uint32_t RPMTAG_ARCH            = 1022;
+const uint32_t RPMTAG_FILEMODES       = 1030;
+const uint32_t RPMTAG_FILEFLAGS       = 1037;
+const uint32_t RPMTAG_SOURCERPM       = 1044;
+const uint32_t RPMTAG_ARCHIVESIZE     = 1046;
+const uint32_t RPMTAG_PROVIDENAME     = 1047;
+const uint32_t RPMTAG_REQUIREFLAGS    = 1048;
+const uint32_t RPMTAG_REQUIRENAME     = 1049;
+const uint32_t RPMTAG_REQUIREVERSION  = 1050;
+const uint32_t RPMTAG_CONFLICTFLAGS   = 1053;
+const uint32_t RPMTAG_CONFLICTNAME    = 1054;
+const uint32_t RPMTAG_CONFLICTVERSION = 1055;
+const uint32_t RPMTAG_CHANGELOGTIME   = 1080;
+const uint32_t RPMTAG_CHANGELOGNAME   = 1081;
+const uint32_t RPMTAG_CHANGELOGTEXT   = 1082;
+const uint32_t RPMTAG_OBSOLETENAME    = 1090;
+const uint32_t RPMTAG_PROVIDEFLAGS    = 1112;
+const uint32_t RPMTAG_PROVIDEVERSION  = 1113;
+const uint32_t RPMTAG_OBSOLETEFLAGS   = 1114;
+const uint32_t RPMTAG_OBSOLETEVERSION = 1115;
+const uint32_t RPMTAG_DIRINDEXES      = 1116;
+const uint32_t RPMTAG_BASENAMES       = 1117;
+const uint32_t RPMTAG_DIRNAMES        = 1118;
+
+// signature header tags
+const uint32_t RPMSIGTAG_PAYLOADSIZE  = 1007;
+
+// dependency sense flags
+const uint32_t RPMSENSE_LESS        = 0x02;
+const uint32_t RPMSENSE_GREATER     = 0x04;
+const uint32_t RPMSENSE_EQUAL       = 0x08;
+const uint32_t RPMSENSE_PREREQ      = 0x40;
+const uint32_t RPMSENSE_SCRIPT_PRE  = 0x200;
+const uint32_t RPMSENSE_SCRIPT_POST = 0x400;
+const uint32_t RPMSENSE_RPMLIB      = 0x1000000;
+
+// file flags
+const uint32_t RPMFILE_GHOST = 0x40;
+
+
+// one entry of the header index
+typedef struct
+{
+    uint32_t tag;
+    uint32_t type;
+    uint32_t offset;
+    uint32_t count;
+} rpm_index_entry_t;
+
+
+// a parsed header, the data store is kept as one blob
+typedef struct
+{
+    std::vector<rpm_index_entry_t> index;
+    std::string store;
+} rpm_header_t;
+
+
+// one dependency (requires, provides, conflicts or obsoletes)
+typedef struct
+{
+    std::string name;
+    uint32_t flags;
+    std::string version;
+} rpm_dep_t;
+
+
+// one file of the package payload
+typedef struct
+{
+    std::string path;
+    uint32_t mode;
+    uint32_t flags;
+} rpm_file_t;
+
+
+// a parsed package, payload_offset is where the compressed cpio archive starts
+typedef struct
+{
+    rpm_header_t signature;
+    rpm_header_t header;
+    uint64_t header_offset;
+    uint64_t payload_offset;
+} rpm_package_t;
+
+
+/*
+ * Function to read a big-endian 32-bit integer
+ */
+inline uint32_t rpm_be32(const unsigned char* p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+
+/*
+ * Function to read one header structure at the current stream position
+ */
+inline bool rpm_read_header(std::istream& in, rpm_header_t& hdr)
+{
+    unsigned char intro[16];
+
+    if (!in.read((char*)intro, sizeof(intro)) || memcmp(intro, RPM_HEADER_MAGIC, 4) != 0)
+    {
+        return false;
+    }
+
+    uint32_t nindex = rpm_be32(intro + 8);
+    uint32_t hsize  = rpm_be32(intro + 12);
+
+    if ((uint64_t)nindex * 16 + hsize > RPM_HEADER_MAX_SIZE)
+    {
+        return false;
+    }
+
+    std::string raw(nindex * 16, '\0');
+
+    if (!in.read(&raw[0], raw.size()))
+    {
+        return false;
+    }
+
+    hdr.index.resize(nindex);
+
+    for (uint32_t i = 0; i < nindex; i++)
+    {
+        const unsigned char* e = (const unsigned char*)raw.data() + i * 16;
+        hdr.index[i] = {rpm_be32(e), rpm_be32(e + 4), rpm_be32(e + 8), rpm_be32(e + 12)};
+    }
+
+    hdr.store.resize(hsize);
+
+    if (hsize > 0 && !in.read(&hdr.store[0], hsize))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+
+/*
+ * Function to read the lead, signature and main header of a package file
+ */
+inline bool rpm_read_package(std::string const& path, rpm_package_t& pkg)
+{
+    std::ifstream in(path, std::ios::binary);
+    unsigned char lead[RPM_LEAD_SIZE];
+
+    if (!in.read((char*)lead, sizeof(lead)) || memcmp(lead, RPM_LEAD_MAGIC, 4) != 0)
+    {
+        return false;
+    }
+
+    if (!rpm_read_header(in, pkg.signature))
+    {
+        return false;
+    }
+
+    // the signature header is padded to an 8-byte boundary
+    uint64_t sig_size = 16 + pkg.signature.index.size() * 16 + pkg.signature.store.size();
+    in.seekg((8 - sig_size % 8) % 8, std::ios::cur);
+    pkg.header_offset = RPM_LEAD_SIZE + sig_size + (8 - sig_size % 8) % 8;
+
+    if (!rpm_read_header(in, pkg.header))
+    {
+        return false;
+    }
+
+    pkg.payload_offset = pkg.header_offset + 16 + pkg.header.index.size() * 16 + pkg.header.store.size();
+
+    return true;
+}
+
+
+/*
+ * Function to find a tag in the header index, returns nullptr if missing
+ */
+inline const rpm_index_entry_t* rpm_find_tag(rpm_header_t const& hdr, uint32_t tag)
+{
+    for (auto const& entry : hdr.index)
+    {
+        if (entry.tag == tag)
+        {
+            return entry.offset < hdr.store.size() ? &entry : nullptr;
+        }
+    }
+
+    return nullptr;
+}
+
+
+/*
+ * Function to get a string array tag, plain strings are returned as one element
+ */
+inline std::vector<std::string> rpm_get_strings(rpm_header_t const& hdr, uint32_t tag)
+{
+    std::vector<std::string> values;
+    const rpm_index_entry_t* entry = rpm_find_tag(hdr, tag);
+
+    if (entry == nullptr
+        || (entry->type != RPM_TYPE_STRING && entry->type != RPM_TYPE_STRING_ARRAY
+            && entry->type != RPM_TYPE_I18NSTRING))
+    {
+        return values;
+    }
+
+    uint32_t count = entry->type == RPM_TYPE_STRING ? 1 : entry->count;
+    size_t pos = entry->offset;
+
+    for (uint32_t i = 0; i < count && pos < hdr.store.size(); i++)
+    {
+        size_t end = hdr.store.find('\0', pos);
+
+        if (end == std::string::npos)
+        {
+            break;
+        }
+
+        values.emplace_back(hdr.store, pos, end - pos);
+        pos = end + 1;
+    }
+
+    return values;
+}
+
+
+/*
+ * Function to get a string tag, returns an empty string if missing
+ */
+inline std::string rpm_get_string(rpm_header_t const& hdr, uint32_t tag)
+{
+    std::vector<std::string> values = rpm_get_strings(hdr, tag);
+    return values.empty() ? std::string() : values[0];
+}
+
+
+/*
+ * Function to get an integer array tag widened to 64 bits
+ */
+inline std::vector<uint64_t> rpm_get_ints(rpm_header_t const& hdr, uint32_t tag)
+{
+    std::vector<uint64_t> values;
+    const rpm_index_entry_t* entry = rpm_find_tag(hdr, tag);
+
+    if (entry == nullptr)
+    {
+        return values;
+    }
+
+    size_t width;
+
+    switch (entry->type)
+    {
+        case RPM_TYPE_CHAR:
+        case RPM_TYPE_INT8:  width = 1; break;
+        case RPM_TYPE_INT16: width = 2; break;
+        case RPM_TYPE_INT32: width = 4; break;
+        case RPM_TYPE_INT64: width = 8; break;
+        default:             return values;
+    }
+
+    if (entry->offset + (uint64_t)entry->count * width > hdr.store.size())
+    {
+        return values;
+    }
+
+    const unsigned char* p = (const unsigned char*)hdr.store.data() + entry->offset;
+    values.reserve(entry->count);
+
+    for (uint32_t i = 0; i < entry->count; i++, p += width)
+    {
+        uint64_t v = 0;
+
+        for (size_t b = 0; b < width; b++)
+        {
+            v = (v << 8) | p[b];
+        }
+
+        values.push_back(v);
+    }
+
+    return values;
+}
+
+
+/*
+ * Function to get an integer tag, returns def if missing
+ */
+inline uint64_t rpm_get_int(rpm_header_t const& hdr, uint32_t tag, uint64_t def = 0)
+{
+    std::vector<uint64_t> values = rpm_get_ints(hdr, tag);
+    return values.empty() ? def : values[0];
+}
+
+
+/*
+ * Function to get the dependencies stored in a name/flags/version tag triple
+ */
+inline std::vector<rpm_dep_t> rpm_get_deps(rpm_header_t const& hdr, uint32_t name_tag, uint32_t flags_tag,
+                                           uint32_t version_tag)
+{
+    std::vector<std::string> names    = rpm_get_strings(hdr, name_tag);
+    std::vector<std::string> versions = rpm_get_strings(hdr, version_tag);
+    std::vector<uint64_t> flags       = rpm_get_ints(hdr, flags_tag);
+    std::vector<rpm_dep_t> deps;
+
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        deps.push_back({names[i],
+                        i < flags.size() ? (uint32_t)flags[i] : 0,
+                        i < versions.size() ? versions[i] : std::string()});
+    }
+
+    return deps;
+}
+
+
+/*
+ * Function to get the full paths of the packaged files
+ */
+inline std::vector<rpm_file_t> rpm_get_files(rpm_header_t const& hdr)
+{
+    std::vector<std::string> basenames = rpm_get_strings(hdr, RPMTAG_BASENAMES);
+    std::vector<std::string> dirnames  = rpm_get_strings(hdr, RPMTAG_DIRNAMES);
+    std::vector<uint64_t> dirindexes   = rpm_get_ints(hdr, RPMTAG_DIRINDEXES);
+    std::vector<uint64_t> modes        = rpm_get_ints(hdr, RPMTAG_FILEMODES);
+    std::vector<uint64_t> flags        = rpm_get_ints(hdr, RPMTAG_FILEFLAGS);
+    std::vector<rpm_file_t> files;
+
+    for (size_t i = 0; i < basenames.size() && i < dirindexes.size(); i++)
+    {
+        if (dirindexes[i] >= dirnames.size())
+        {
+            continue;
+        }
+
+        files.push_back({dirnames[dirindexes[i]] + basenames[i],
+                         i < modes.size() ? (uint32_t)modes[i] : 0,
+                         i < flags.size() ? (uint32_t)flags[i] : 0});
+    }
+
+    return files;
+}
+
+
+/*
+ * Function to format the requires the same way as 'rpm -qp --requires'
+ */
+inline std::vector<std::string> rpm_get_requires(rpm_header_t const& hdr)
+{
+    std::vector<std::string> requires_list;
+
+    for (auto const& dep : rpm_get_deps(hdr, RPMTAG_REQUIRENAME, RPMTAG_REQUIREFLAGS, RPMTAG_REQUIREVERSION))
+    {
+        std::string line = dep.name;
+
+        if (!dep.version.empty())
+        {
+            std::string sense;
+
+            if (dep.flags & RPMSENSE_LESS)
+                sense += "<";
+            if (dep.flags & RPMSENSE_GREATER)
+                sense += ">";
+            if (dep.flags & RPMSENSE_EQUAL)
+                sense += "=";
+
+            line += " " + sense + " " + dep.version;
+        }
+
+        requires_list.push_back(line);
+    }
+
+    return requires_list;
+}
+
+#endif /* _RPMHEADER_H */
@@ -1,14 +1,18 @@
-#!/bin/sh
+#!/bin/bash
 #
 # Author:
 # Tuan Hoang <tqhoang@elrepo.org>
 #
 # Description:
 # This script loops over all instaled kmods and calls getkmoddevs-single.sh on each *.ko file
+# (also *.ko.xz, *.ko.gz and *.ko.zst, listed under their *.ko name)
 #
 # Note:
 # - Applies a blacklist filter for *.ko files that do not have device info
 # - Applies a quirklist workaround for drivers missing device info
+# - Both lists are read from getkmoddevs.conf (override with KMOD_CONF)
+# - The kmod -> RPM mapping is built once with a single rpmdb query
+# - The modinfo of all kmods is read in one batch by kmodinfo
 #
 # Assumes:
 # - Only ELRepo kmods are installed
@@ -18,66 +22,110 @@
 #
 
 
-# Array for RHEL kmods blacklist
-kmod_blacklist=("kvdo.ko" "uds.ko" "oracleasm.ko")
-# Append ELRepo EL9 and EL10 kmods
-kmod_blacklist+=("drbd.ko" "drbd_transport_lb-tcp.ko" "drbd_transport_rdma.ko" "drbd_transport_tcp.ko" "dvb-core.ko" "ecryptfs.ko" "em28xx-alsa.ko" "em28xx-dvb.ko" "em28xx-rc.ko" "em28xx-v4l.ko" "floppy.ko" "hfs.ko" "hfsplus.ko" "hid-mcp2221.ko" "led-class-multicolor.ko" "leds-gpio.ko" "leds-pca9532.ko" "libsas.ko" "lgdt330x.ko" "megaraid_mm.ko" "mlx4_en.ko" "mlx4_ib.ko" "mptctl.ko" "mt792x-usb.ko" "nvidia-drm.ko" "nvidia-modeset.ko" "nvidia-peermem.ko" "nvidia-uvm.ko" "ovpn-dco-v2.ko" "ovpn.ko" "rc-core.ko" "rc-pinnacle-pctv-hd.ko" "rtw88_8723d.ko" "rtw88_8812a.ko" "rtw88_8814a.ko" "rtw88_8821a.ko" "rtw88_8821c.ko" "rtw88_88xxa.ko" "rtw88_usb.ko" "tvp5150.ko" "usbip-core.ko" "usbip-host.ko" "vhci-hcd.ko" "v4l2-async.ko" "v4l2-fwnode.ko" "v4l2loopback.ko" "xc2028.ko" "xt_time.ko" "xt_u32.ko" "zl10353.ko")
-# Append ELRepo EL8-only kmods
-kmod_blacklist+=("ath.ko" "bnxt_re.ko" "ftsteutates.ko" "handshake.ko" "iwlegacy.ko" "jfs.ko" "lru_cache.ko" "sch_cake.ko" "sysv.ko" "wireguard.ko")
+# Config file with the blacklist and quirklist rules
+kmod_conf="${KMOD_CONF:-$(dirname $0)/getkmoddevs.conf}"
 
-# Array for kmod quirklist
-kmod_quirklist=("a2818.ko" "si2157.ko")
+# Hash sets for the kmod blacklist and quirklist
+declare -A kmod_blacklist
+declare -A kmod_quirklist
 
-# Array for kmod RPM names
-kmod_rpmlist=()
+# Hash map of kmod path -> RPM name
+declare -A kmod_rpm_map
+
+# Hash set of RPM names already printed
+declare -A kmod_rpm_seen
 
-# Function to check if the array has an element
 set +e #otherwise the script will exit on error
-function containsElement () {
-	local e match="$1"
-	shift
-	for e; do [[ "$e" == "$match" ]] && return 0; done
-	return 1
+
+
+# Function to print the *.ko name of a kmod path, without the compression suffix
+function kmodBasename() {
+	local name="${1##*/}"
+	name="${name%.xz}"
+	name="${name%.gz}"
+	echo "${name%.zst}"
 }
 
 
-# Loop over all kmods for the kernel
-for kmod in `find /lib/modules/*/extra -name "*.ko" | sort`
+# Load the rules from the config file
+while read -r rule name
+do
+	case "${rule}" in
+		blacklist) kmod_blacklist["${name}"]=1 ;;
+		quirk)     kmod_quirklist["${name}"]=1 ;;
+	esac
+done < <(grep -v '^[[:space:]]*#' "${kmod_conf}")
+
+
+# Map every kmod file to its RPM with a single rpmdb query
+while IFS=$'\t' read -r path name
+do
+	kmod_rpm_map["${path}"]="${name}"
+done < <(rpm -qa --queryformat "[%{FILENAMES}\t%{=NAME}\n]" "kmod-*" | grep -E '/extra/.*\.ko(\.xz|\.gz|\.zst)?\s')
+
+if [ ${#kmod_rpm_map[@]} -eq 0 ]
+then
+	echo "ERROR: no kmod files found in the rpmdb (rpm -qa kmod-*)" >&2
+	exit 1
+fi
+
+
+# Collect all kmods for the kernel, filtering the blacklist
+kmods=()
+for kmod in `find /lib/modules/*/extra \( -name "*.ko" -o -name "*.ko.xz" -o -name "*.ko.gz" -o -name "*.ko.zst" \) | sort`
 do
-	# filter blacklist
-	containsElement "`basename $kmod`" "${kmod_blacklist[@]}"
-	if [ $? == 0 ]
+	if [ -z "${kmod_blacklist[$(kmodBasename ${kmod})]}" ]
+	then
+		kmods+=( "${kmod}" )
+	fi
+done
+
+
+# Read the modinfo of all kmods in one batch, <index>.modinfo per kmod
+modinfo_dir=`mktemp -d`
+trap 'rm -rf "${modinfo_dir}"' EXIT
+if [ ${#kmods[@]} -gt 0 ]
+then
+	printf "%s\n" "${kmods[@]}" | ./kmodinfo -o "${modinfo_dir}"
+fi
+
+
+# Loop over all kmods
+for index in "${!kmods[@]}"
+do
+	kmod="${kmods[${index}]}"
+	kmod_name=$(kmodBasename ${kmod})
+
+	# get the RPM name, falling back to a single query for paths missing from the map
+	KMOD_RPM="${kmod_rpm_map[${kmod}]}"
+	if [ -z "${KMOD_RPM}" ]
 	then
-		continue
+		echo "WARNING: ${kmod} missing from the rpmdb map, querying it alone" >&2
+		KMOD_RPM=`rpm --queryformat "%{name}" -qf ${kmod}`
 	fi
-	
-	# get the RPM name
-	KMOD_RPM=`rpm --queryformat "%{name}" -qf ${kmod}`
 
 	# only print the RPM name once
-	containsElement "${KMOD_RPM}" "${kmod_rpmlist[@]}"
-	if [ $? == 1 ]
+	if [ -z "${kmod_rpm_seen[${KMOD_RPM}]}" ]
 	then
-		kmod_rpmlist+=(${KMOD_RPM})
+		kmod_rpm_seen["${KMOD_RPM}"]=1
 		echo "===== ${KMOD_RPM} ====="
 	fi
 
 	# print the kmod name
-	echo "(`basename $kmod`) \\\\"
+	echo "(${kmod_name}) \\\\"
 
 	# check quirklist
-	containsElement "`basename $kmod`" "${kmod_quirklist[@]}"
-	if [ $? == 1 ]
+	if [ -z "${kmod_quirklist[${kmod_name}]}" ]
 	then
-		./getkmoddevs-single.sh $kmod
+		./getkmoddevs-single.sh $kmod "${modinfo_dir}/${index}.modinfo"
 	else
 		# hack for kmod-a2818
-		if [ "`basename $kmod`" == "a2818.ko" ]
+		if [ "${kmod_name}" == "a2818.ko" ]
 		then
 			./lsdevname -n -v 10B5 -d 9054
 			echo " \\\\"
 			echo " \\\\"
-		elif [ "`basename $kmod`" == "si2157.ko" ]
+		elif [ "${kmod_name}" == "si2157.ko" ]
 		then
 			echo "[i2c:si2141] I2C UNKNOWN DEVICE si2141 \\\\"
 			echo "[i2c:si2146] I2C UNKNOWN DEVICE si2146 \\\\"
@@ -6,6 +6,12 @@
 # Description:
 # This script prints all the device info for a single kmod filename (*.ko)
 #
+# Usage:
+# getkmoddevs-single.sh <kmod filename> [<modinfo output file>]
+#
+# The optional second argument holds the modinfo output prepared in advance
+# (ex. by kmodinfo), otherwise modinfo is run once on the kmod
+#
 # Output format:
 # (<kmod filename>)
 # [<vendor ID>:<device ID>] <vendor name> <device name> \\
@@ -60,11 +66,20 @@ function printUsbInfo() {
 }
 
 
+# Read the module aliases once
+if [ -n "$2" ]
+then
+	kmod_aliases=`grep alias "$2"`
+else
+	kmod_aliases=`modinfo $1 | grep alias`
+fi
+
+
 #
 # PCI Device IDs
 #
-pci_array+=( $(modinfo $1 | grep alias | grep -e "pci:" | grep "d\*sv" | awk '{print substr($0,26,4)":"}' | sort | uniq) )
-pci_array+=( $(modinfo $1 | grep alias | grep -e "pci:" | grep -v "d\*sv" | awk '{print substr($0,26,4)":"substr($0,35,4)}' | sort | uniq) )
+pci_array+=( $(echo "${kmod_aliases}" | grep -e "pci:" | grep "d\*sv" | awk '{print substr($0,26,4)":"}' | sort | uniq) )
+pci_array+=( $(echo "${kmod_aliases}" | grep -e "pci:" | grep -v "d\*sv" | awk '{print substr($0,26,4)":"substr($0,35,4)}' | sort | uniq) )
 
 # will echo number of elements in array
 # echo ${#pci_array[@]}
@@ -75,8 +90,8 @@ pci_array+=( $(modinfo $1 | grep alias | grep -e "pci:" | grep -v "d\*sv" | awk
 #
 # USB Device IDs
 #
-usb_array+=( $(modinfo $1 | grep alias | grep -e "usb:" | grep -v "v\*p\*d\*dc" | grep "p\*d\*dc" | awk '{print substr($0,22,4)":"}' | sort | uniq) )
-usb_array+=( $(modinfo $1 | grep alias | grep -e "usb:" | grep -v "v\*p\*d\*dc" | grep -v "p\*d\*dc" | awk '{print substr($0,22,4)":"substr($0,27,4)}' | sort | uniq) )
+usb_array+=( $(echo "${kmod_aliases}" | grep -e "usb:" | grep -v "v\*p\*d\*dc" | grep "p\*d\*dc" | awk '{print substr($0,22,4)":"}' | sort | uniq) )
+usb_array+=( $(echo "${kmod_aliases}" | grep -e "usb:" | grep -v "v\*p\*d\*dc" | grep -v "p\*d\*dc" | awk '{print substr($0,22,4)":"substr($0,27,4)}' | sort | uniq) )
 
 # will echo number of elements in array
 # echo ${#usb_array[@]}
@@ -87,7 +102,7 @@ usb_array+=( $(modinfo $1 | grep alias | grep -e "usb:" | grep -v "v\*p\*d\*dc"
 #
 # HID Device IDs
 #
-hid_array+=( $(modinfo $1 | grep alias | grep -e "hid:" | awk '{print substr($0,33,4)":"substr($0,42,4)}' | sort | uniq) )
+hid_array+=( $(echo "${kmod_aliases}" | grep -e "hid:" | awk '{print substr($0,33,4)":"substr($0,42,4)}' | sort | uniq) )
 
 # will echo number of elements in array
 #echo ${#hid_array[@]}
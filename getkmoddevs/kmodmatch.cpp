@@ -0,0 +1,632 @@
+/*
+ *  kmodmatch - Prints the kmods whose aliases match the devices of a machine
+ *
+ *  Note:
+ *  The alias patterns of all modules (globs like pci:v000010DEd*sv*sd*bc03sc*i*)
+ *  are compiled into one trie. It is run as a DFA built on demand, so every
+ *  device modalias is matched in a single pass over its characters, instead
+ *  of one fnmatch() call per alias.
+ *
+ *  Copyright (C) 2026 The ELRepo Project <https://elrepo.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/utsname.h>
+
+#include "kmodreader.h"
+
+using namespace std;
+
+#include <getopt.h>
+extern char *optarg;
+extern int optind, opterr, optopt;
+
+
+// "?" and "[...]" edge of the alias trie
+typedef struct
+{
+	string text;
+	bitset<256> chars;
+	int next;
+} alias_class_t;
+
+// alias trie node
+typedef struct
+{
+	map<unsigned char, int> literal;
+	vector<alias_class_t> classes;
+	int star;			// "*" edge, -1 if none
+	bool loop;			// reached by "*", takes any character again
+	vector<int> modules;		// modules with an alias ending here
+} alias_node_t;
+
+// DFA state, a set of trie nodes
+typedef struct
+{
+	vector<int> nodes;
+	vector<int> modules;		// matched modules when the modalias ends here
+	array<int, 256> next;		// built on demand, -1 if not yet
+} alias_state_t;
+
+typedef struct
+{
+	vector<alias_node_t> nodes;
+	vector<alias_state_t> states;
+	map<vector<int>, int> state_index;
+} alias_matcher_t;
+
+// device with a modalias
+typedef struct
+{
+	string path;
+	string modalias;
+} sysfs_device_t;
+
+// module file names
+const vector<string> KMOD_SUFFIXES = {".ko", ".ko.xz", ".ko.gz", ".ko.zst"};
+
+// function prototypess
+void print_usage(char* progname);
+bool has_kmod_suffix(string const& name);
+void find_kmods(string const& dir, vector<string>& kmods);
+void find_modaliases(string const& root, string const& rel, vector<sysfs_device_t>& devices);
+int alias_node(alias_matcher_t& matcher);
+size_t alias_parse_class(string const& pattern, size_t pos, bitset<256>& chars);
+void alias_add(alias_matcher_t& matcher, string const& pattern, int module);
+int alias_state(alias_matcher_t& matcher, vector<int> nodes);
+int alias_step(alias_matcher_t& matcher, int state, unsigned char c);
+const vector<int>& alias_match(alias_matcher_t& matcher, string const& modalias);
+
+
+/*
+ * Function to print usage
+ */
+void print_usage(char* progname)
+{
+	cerr << "Usage: " << progname << " [options]" << endl
+	     << "-r,--sysfs-root <dir>  :  sysfs root (default /sys)" << endl
+	     << "-m,--moddir <dir>      :  module directory, may be repeated" << endl
+	     << "                          (default /lib/modules/$(uname -r)/extra)" << endl
+	     << "-a,--all               :  also print devices without a matching module" << endl
+	     << "-j,--jobs <n>          :  threads when io_uring is unavailable" << endl
+	     << "-h,--help              :  show help" << endl
+	     << endl;
+}
+
+
+/*
+ * main program
+ */
+int main(int argc, char** argv)
+{
+	char* prog_name = argv[0];
+
+	string sysfs_root = "/sys";
+	vector<string> mod_dirs;
+	int print_all = 0;
+	unsigned int jobs = thread::hardware_concurrency();
+
+
+	const char* const optstring = "r:m:aj:h";
+	const option long_options[] = {
+		{"sysfs-root", required_argument, nullptr, 'r'},
+		{"moddir", required_argument, nullptr, 'm'},
+		{"all", no_argument, nullptr, 'a'},
+		{"jobs", required_argument, nullptr, 'j'},
+		{"help", no_argument, nullptr, 'h'},
+		{nullptr, no_argument, nullptr, 0}
+	};
+	int option_index;
+
+	while (true)
+	{
+		const auto opt = getopt_long(argc, argv, optstring, long_options, &option_index);
+
+		if (-1 == opt)
+			break;
+
+		switch (opt)
+		{
+			case 'r':
+				sysfs_root = optarg;
+				break;
+
+			case 'm':
+				mod_dirs.push_back(optarg);
+				break;
+
+			case 'a':
+				print_all = 1;
+				break;
+
+			case 'j':
+				jobs = atoi(optarg);
+				break;
+
+			case 'h': // -h or --help
+			case '?': // Unrecognized option
+			default:
+				print_usage(prog_name);
+				return EXIT_FAILURE;
+		}
+	}
+
+	if (optind < argc)
+	{
+		print_usage(prog_name);
+		return EXIT_FAILURE;
+	}
+
+	// default to the kmods of the running kernel
+	if (mod_dirs.empty())
+	{
+		struct utsname uts;
+		uname(&uts);
+		mod_dirs.push_back(string("/lib/modules/") + uts.release + "/extra");
+	}
+
+	// read the aliases of all modules
+	vector<string> kmods;
+
+	for (auto& dir : mod_dirs)
+	{
+		find_kmods(dir, kmods);
+	}
+
+	sort(kmods.begin(), kmods.end());
+	kmods.erase(unique(kmods.begin(), kmods.end()), kmods.end());
+
+	if (kmods.empty())
+	{
+		cerr << prog_name << ": ERROR: no modules found" << endl;
+		return EXIT_FAILURE;
+	}
+
+	vector<kmod_file_t> files(kmods.size());
+
+	for (size_t i = 0; i < kmods.size(); i++)
+	{
+		files[i].path = kmods[i];
+	}
+
+	kmod_read_modinfo(files, jobs);
+
+	// compile the aliases
+	alias_matcher_t matcher;
+	alias_node(matcher);
+
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (!files[i].error.empty())
+		{
+			cerr << prog_name << ": WARNING: " << files[i].path << ": " << files[i].error << endl;
+			continue;
+		}
+
+		for (auto& kv : kmod_modinfo_fields(files[i].modinfo))
+		{
+			if (kv.first == "alias")
+				alias_add(matcher, kv.second, i);
+		}
+	}
+
+	// match every device
+	vector<sysfs_device_t> devices;
+	find_modaliases(sysfs_root + "/devices", "", devices);
+
+	if (devices.empty())
+	{
+		cerr << prog_name << ": ERROR: no modalias files found in " << sysfs_root << "/devices" << endl;
+		return EXIT_FAILURE;
+	}
+
+	sort(devices.begin(), devices.end(),
+	     [](sysfs_device_t const& a, sysfs_device_t const& b){ return a.path < b.path; });
+
+	string output;
+
+	for (auto& dev : devices)
+	{
+		const vector<int>& modules = alias_match(matcher, dev.modalias);
+
+		if (modules.empty() && !print_all)
+			continue;
+
+		output += dev.path + " [" + dev.modalias + "]";
+
+		// a module may be installed for several kernels, print its name once
+		vector<string> names;
+
+		for (int m : modules)
+		{
+			names.push_back(kmods[m].substr(kmods[m].rfind('/') + 1));
+		}
+
+		sort(names.begin(), names.end());
+		names.erase(unique(names.begin(), names.end()), names.end());
+
+		for (auto& name : names)
+		{
+			output += " " + name;
+		}
+
+		if (names.empty())
+			output += " -";
+
+		output += "\n";
+	}
+
+	cout << output;
+	cout.flush();
+
+	return EXIT_SUCCESS;
+}
+
+
+/*
+ * Function to check for a module file name
+ */
+bool has_kmod_suffix(string const& name)
+{
+	for (auto& suffix : KMOD_SUFFIXES)
+	{
+		if (name.size() > suffix.size()
+		    && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+
+/*
+ * Function to find the modules under a directory
+ * Symlinked modules (weak-updates) are kept, symlinked directories are not followed
+ */
+void find_kmods(string const& dir, vector<string>& kmods)
+{
+	DIR* d = opendir(dir.c_str());
+
+	if (d == nullptr)
+		return;
+
+	struct dirent* entry;
+
+	while ((entry = readdir(d)) != nullptr)
+	{
+		string name = entry->d_name;
+
+		if (name == "." || name == "..")
+			continue;
+
+		if (entry->d_type == DT_DIR)
+			find_kmods(dir + "/" + name, kmods);
+		else if (has_kmod_suffix(name))
+			kmods.push_back(dir + "/" + name);
+	}
+
+	closedir(d);
+}
+
+
+/*
+ * Function to find the modalias files under <sysfs root>/devices
+ * Symlinks (subsystem, driver, ...) are not followed
+ */
+void find_modaliases(string const& root, string const& rel, vector<sysfs_device_t>& devices)
+{
+	string dir = rel.empty() ? root : root + "/" + rel;
+	DIR* d = opendir(dir.c_str());
+
+	if (d == nullptr)
+		return;
+
+	struct dirent* entry;
+
+	while ((entry = readdir(d)) != nullptr)
+	{
+		string name = entry->d_name;
+
+		if (name == "." || name == "..")
+			continue;
+
+		if (entry->d_type == DT_DIR)
+		{
+			find_modaliases(root, rel.empty() ? name : rel + "/" + name, devices);
+		}
+		else if (entry->d_type == DT_REG && name == "modalias")
+		{
+			char buf[512];
+			int fd = openat(dirfd(d), "modalias", O_RDONLY | O_CLOEXEC);
+
+			if (fd < 0)
+				continue;
+
+			ssize_t len = read(fd, buf, sizeof(buf));
+			close(fd);
+
+			while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\0'))
+				len--;
+
+			if (len > 0)
+				devices.push_back({rel, string(buf, len)});
+		}
+	}
+
+	closedir(d);
+}
+
+
+/*
+ * Function to add an empty node to the alias trie
+ */
+int alias_node(alias_matcher_t& matcher)
+{
+	matcher.nodes.emplace_back();
+	matcher.nodes.back().star = -1;
+	matcher.nodes.back().loop = false;
+
+	return matcher.nodes.size() - 1;
+}
+
+
+/*
+ * Function to parse a "[...]" bracket expression the way fnmatch does
+ * Returns the position after the closing bracket, or 0 if there is none
+ * (the "[" is a literal then)
+ */
+size_t alias_parse_class(string const& pattern, size_t pos, bitset<256>& chars)
+{
+	size_t i = pos + 1;
+	bool negate = false;
+
+	chars.reset();
+
+	if (i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^'))
+	{
+		negate = true;
+		i++;
+	}
+
+	// a leading "]" is part of the set
+	bool first = true;
+
+	for (; i < pattern.size(); i++)
+	{
+		unsigned char c = pattern[i];
+
+		if (c == ']' && !first)
+		{
+			if (negate)
+				chars.flip();
+
+			return i + 1;
+		}
+
+		first = false;
+
+		if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']')
+		{
+			for (unsigned int r = c; r <= (unsigned char)pattern[i + 2]; r++)
+			{
+				chars.set(r);
+			}
+
+			i += 2;
+		}
+		else
+		{
+			chars.set(c);
+		}
+	}
+
+	return 0;
+}
+
+
+/*
+ * Function to add one alias pattern of a module to the trie
+ */
+void alias_add(alias_matcher_t& matcher, string const& pattern, int module)
+{
+	int node = 0;
+
+	for (size_t i = 0; i < pattern.size(); i++)
+	{
+		unsigned char c = pattern[i];
+		int next = -1;
+
+		if (c == '*')
+		{
+			next = matcher.nodes[node].star;
+
+			if (next < 0)
+			{
+				next = alias_node(matcher);
+				matcher.nodes[next].loop = true;
+				matcher.nodes[node].star = next;
+			}
+
+			node = next;
+			continue;
+		}
+
+		bitset<256> chars;
+		size_t end = 0;
+
+		if (c == '?')
+		{
+			chars.set();
+			end = i + 1;
+		}
+		else if (c == '[')
+		{
+			end = alias_parse_class(pattern, i, chars);
+		}
+
+		if (end > 0)
+		{
+			// share edges with the same bracket text
+			string text = pattern.substr(i, end - i);
+
+			for (auto& cls : matcher.nodes[node].classes)
+			{
+				if (cls.text == text)
+					next = cls.next;
+			}
+
+			if (next < 0)
+			{
+				next = alias_node(matcher);
+				matcher.nodes[node].classes.push_back({text, chars, next});
+			}
+
+			node = next;
+			i = end - 1;
+			continue;
+		}
+
+		// escaped character
+		if (c == '\\' && i + 1 < pattern.size())
+			c = pattern[++i];
+
+		auto iter = matcher.nodes[node].literal.find(c);
+
+		if (iter != matcher.nodes[node].literal.end())
+		{
+			node = iter->second;
+		}
+		else
+		{
+			next = alias_node(matcher);
+			matcher.nodes[node].literal[c] = next;
+			node = next;
+		}
+	}
+
+	matcher.nodes[node].modules.push_back(module);
+}
+
+
+/*
+ * Function to get the DFA state for a set of trie nodes, "*" edges match
+ * the empty string so their targets are added first
+ */
+int alias_state(alias_matcher_t& matcher, vector<int> nodes)
+{
+	for (size_t i = 0; i < nodes.size(); i++)
+	{
+		int star = matcher.nodes[nodes[i]].star;
+
+		if (star >= 0)
+			nodes.push_back(star);
+	}
+
+	sort(nodes.begin(), nodes.end());
+	nodes.erase(unique(nodes.begin(), nodes.end()), nodes.end());
+
+	auto iter = matcher.state_index.find(nodes);
+
+	if (iter != matcher.state_index.end())
+		return iter->second;
+
+	alias_state_t state;
+	state.next.fill(-1);
+
+	for (int n : nodes)
+	{
+		auto const& modules = matcher.nodes[n].modules;
+		state.modules.insert(state.modules.end(), modules.begin(), modules.end());
+	}
+
+	sort(state.modules.begin(), state.modules.end());
+	state.modules.erase(unique(state.modules.begin(), state.modules.end()), state.modules.end());
+	state.nodes = nodes;
+
+	matcher.states.push_back(state);
+	matcher.state_index[nodes] = matcher.states.size() - 1;
+
+	return matcher.states.size() - 1;
+}
+
+
+/*
+ * Function to follow one character from a DFA state
+ */
+int alias_step(alias_matcher_t& matcher, int state, unsigned char c)
+{
+	int next = matcher.states[state].next[c];
+
+	if (next >= 0)
+		return next;
+
+	vector<int> nodes;
+
+	for (int n : matcher.states[state].nodes)
+	{
+		alias_node_t const& node = matcher.nodes[n];
+
+		if (node.loop)
+			nodes.push_back(n);
+
+		auto iter = node.literal.find(c);
+
+		if (iter != node.literal.end())
+			nodes.push_back(iter->second);
+
+		for (auto& cls : node.classes)
+		{
+			if (cls.chars.test(c))
+				nodes.push_back(cls.next);
+		}
+	}
+
+	next = alias_state(matcher, nodes);
+	matcher.states[state].next[c] = next;
+
+	return next;
+}
+
+
+/*
+ * Function to get the modules matching a modalias
+ * All aliases must have been added before the first call
+ */
+const vector<int>& alias_match(alias_matcher_t& matcher, string const& modalias)
+{
+	int state = alias_state(matcher, {0});
+
+	for (unsigned char c : modalias)
+	{
+		state = alias_step(matcher, state, c);
+
+		// no alias can match anymore
+		if (matcher.states[state].nodes.empty())
+			break;
+	}
+
+	return matcher.states[state].modules;
+}
@@ -0,0 +1,1002 @@
+/*
+ *  kmodreader.h - Reads the .modinfo section of many kernel modules at once
+ *
+ *  Only the ELF header, the section header table, the section name table
+ *  and the .modinfo section of every module are read, never the whole file.
+ *  The opens, statx calls and reads of all modules are submitted in batches
+ *  through io_uring, one batch per step. When io_uring is unavailable the
+ *  same steps run with blocking pread() on a pool of threads.
+ *
+ *  Compressed modules (.ko.xz, .ko.gz and .ko.zst with HAVE_ZSTD) are
+ *  inflated as a stream on the thread pool, each thread reusing its own
+ *  decompression contexts and buffers. The .modinfo section can only be
+ *  located from the section header table, which the linker puts at the end
+ *  of a module, so practically the whole module is inflated and held in
+ *  memory while it is read.
+ *
+ *  Copyright (C) 2026 The ELRepo Project <https://elrepo.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _KMODREADER_H
+#define _KMODREADER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <lzma.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+
+// read steps of one module
+typedef enum
+{
+	KMOD_STEP_OPEN,
+	KMOD_STEP_EHDR,
+	KMOD_STEP_SHDRS,
+	KMOD_STEP_SHSTRTAB,
+	KMOD_STEP_MODINFO,
+	KMOD_STEP_DONE
+} kmod_step_t;
+
+
+// compression of a module file
+typedef enum
+{
+	KMOD_COMP_NONE,
+	KMOD_COMP_XZ,
+	KMOD_COMP_GZ,
+	KMOD_COMP_ZSTD
+} kmod_comp_t;
+
+
+// one module, modinfo receives the raw NUL separated "key=value" strings
+typedef struct
+{
+	std::string path;
+	std::string modinfo;
+	std::string error;
+
+	// read state
+	kmod_step_t step;
+	int fd;
+	uint64_t size;
+	struct statx stx;
+	std::string buf;
+	uint64_t offset;
+	std::string shdrs;
+	bool elf64;
+	bool big_endian;
+	uint32_t shnum;
+	uint32_t shentsize;
+	uint32_t shstrndx;
+} kmod_file_t;
+
+
+// ELF header constants
+const size_t ELF_EHDR_SIZE = 64;
+const unsigned char ELF_MAGIC[4] = {0x7F, 'E', 'L', 'F'};
+const std::string MODINFO_SECTION(".modinfo");
+
+// stream buffer sizes
+const size_t KMOD_IN_CHUNK  = 64 * 1024;
+const size_t KMOD_OUT_CHUNK = 64 * 1024;
+
+// largest inflated buffer a thread keeps for the next module
+const size_t KMOD_OUT_KEEP  = 16 * 1024 * 1024;
+
+// largest inflated module accepted
+const uint64_t KMOD_MAX_INFLATED = 1ULL << 30;
+
+
+/*
+ * Function to read an ELF integer in the byte order of the file
+ */
+inline uint64_t elf_get(kmod_file_t const& kf, const std::string& data, size_t offset, size_t width)
+{
+	if (offset + width > data.size())
+		return 0;
+
+	const unsigned char* p = (const unsigned char*)data.data() + offset;
+	uint64_t v = 0;
+
+	for (size_t i = 0; i < width; i++)
+	{
+		size_t b = kf.big_endian ? i : width - 1 - i;
+		v = (v << 8) | p[b];
+	}
+
+	return v;
+}
+
+
+/*
+ * Function to get the file offset and size of one section
+ */
+inline bool elf_section(kmod_file_t const& kf, uint32_t index, uint32_t& name, uint64_t& offset, uint64_t& size)
+{
+	size_t base = (size_t)index * kf.shentsize;
+
+	if (index >= kf.shnum || base + kf.shentsize > kf.shdrs.size())
+		return false;
+
+	name = elf_get(kf, kf.shdrs, base, 4);
+
+	if (kf.elf64)
+	{
+		offset = elf_get(kf, kf.shdrs, base + 24, 8);
+		size   = elf_get(kf, kf.shdrs, base + 32, 8);
+	}
+	else
+	{
+		offset = elf_get(kf, kf.shdrs, base + 16, 4);
+		size   = elf_get(kf, kf.shdrs, base + 20, 4);
+	}
+
+	return offset <= kf.size && size <= kf.size - offset;
+}
+
+
+/*
+ * Function to fail a module, the caller closes the file
+ */
+inline void kmod_fail(kmod_file_t& kf, std::string const& error)
+{
+	kf.error = error;
+	kf.step = KMOD_STEP_DONE;
+}
+
+
+/*
+ * Function to set up the read of the next step
+ */
+inline void kmod_request(kmod_file_t& kf, uint64_t offset, uint64_t len)
+{
+	if (offset > kf.size || len > kf.size - offset)
+	{
+		kmod_fail(kf, "truncated ELF file");
+		return;
+	}
+
+	kf.offset = offset;
+	kf.buf.resize(len);
+}
+
+
+/*
+ * Function to process the data of the current step and move to the next one
+ * Called after open/statx (buf unused) and after every completed read into buf
+ */
+inline void kmod_advance(kmod_file_t& kf)
+{
+	switch (kf.step)
+	{
+		case KMOD_STEP_OPEN:
+			kf.step = KMOD_STEP_EHDR;
+			kmod_request(kf, 0, ELF_EHDR_SIZE);
+			break;
+
+		case KMOD_STEP_EHDR:
+		{
+			if (memcmp(kf.buf.data(), ELF_MAGIC, 4) != 0)
+			{
+				kmod_fail(kf, "not an ELF file");
+				break;
+			}
+
+			kf.elf64      = kf.buf[4] == 2;
+			kf.big_endian = kf.buf[5] == 2;
+
+			uint64_t shoff = elf_get(kf, kf.buf, kf.elf64 ? 0x28 : 0x20, kf.elf64 ? 8 : 4);
+			kf.shentsize   = elf_get(kf, kf.buf, kf.elf64 ? 0x3A : 0x2E, 2);
+			kf.shnum       = elf_get(kf, kf.buf, kf.elf64 ? 0x3C : 0x30, 2);
+			kf.shstrndx    = elf_get(kf, kf.buf, kf.elf64 ? 0x3E : 0x32, 2);
+
+			if (kf.shnum == 0 || kf.shentsize < (kf.elf64 ? 64u : 40u) || kf.shstrndx >= kf.shnum)
+			{
+				kmod_fail(kf, "no section headers");
+				break;
+			}
+
+			kf.step = KMOD_STEP_SHDRS;
+			kmod_request(kf, shoff, (uint64_t)kf.shnum * kf.shentsize);
+			break;
+		}
+
+		case KMOD_STEP_SHDRS:
+		{
+			kf.shdrs.swap(kf.buf);
+
+			uint32_t name;
+			uint64_t offset, size;
+
+			if (!elf_section(kf, kf.shstrndx, name, offset, size))
+			{
+				kmod_fail(kf, "bad section name table");
+				break;
+			}
+
+			kf.step = KMOD_STEP_SHSTRTAB;
+			kmod_request(kf, offset, size);
+			break;
+		}
+
+		case KMOD_STEP_SHSTRTAB:
+		{
+			uint32_t name;
+			uint64_t offset, size;
+
+			for (uint32_t i = 0; i < kf.shnum; i++)
+			{
+				if (elf_section(kf, i, name, offset, size)
+				    && name < kf.buf.size()
+				    && strcmp(kf.buf.c_str() + name, MODINFO_SECTION.c_str()) == 0)
+				{
+					kf.step = KMOD_STEP_MODINFO;
+					kmod_request(kf, offset, size);
+					return;
+				}
+			}
+
+			kmod_fail(kf, "no .modinfo section");
+			break;
+		}
+
+		case KMOD_STEP_MODINFO:
+			kf.modinfo.swap(kf.buf);
+			kf.buf.clear();
+			kf.shdrs.clear();
+			kf.step = KMOD_STEP_DONE;
+			break;
+
+		case KMOD_STEP_DONE:
+			break;
+	}
+}
+
+
+/*
+ * Function to read one module with blocking syscalls
+ */
+inline void kmod_read_blocking(kmod_file_t& kf)
+{
+	kf.fd = open(kf.path.c_str(), O_RDONLY | O_CLOEXEC);
+
+	if (kf.fd < 0 || statx(kf.fd, "", AT_EMPTY_PATH, STATX_SIZE, &kf.stx) != 0)
+	{
+		kmod_fail(kf, strerror(errno));
+	}
+	else
+	{
+		kf.size = kf.stx.stx_size;
+		kmod_advance(kf);
+	}
+
+	while (kf.step != KMOD_STEP_DONE)
+	{
+		ssize_t n = pread(kf.fd, &kf.buf[0], kf.buf.size(), kf.offset);
+
+		if (n != (ssize_t)kf.buf.size())
+		{
+			kmod_fail(kf, n < 0 ? strerror(errno) : "short read");
+			break;
+		}
+
+		kmod_advance(kf);
+	}
+
+	if (kf.fd >= 0)
+	{
+		close(kf.fd);
+		kf.fd = -1;
+	}
+}
+
+
+// decompression contexts and buffers, reused across the modules of one thread
+typedef struct
+{
+	lzma_stream xz;
+	z_stream gz;
+	bool gz_ready;
+#ifdef HAVE_ZSTD
+	ZSTD_DCtx* zst;
+#endif
+	std::string in;
+	std::string out;
+} kmod_inflater_t;
+
+
+/*
+ * Function to get the compression of a module from its file name
+ */
+inline kmod_comp_t kmod_compression(std::string const& path)
+{
+	auto ends_with = [&](std::string const& suffix)
+	{
+		return path.size() >= suffix.size()
+		       && path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+	};
+
+	if (ends_with(".xz"))
+		return KMOD_COMP_XZ;
+	else if (ends_with(".gz"))
+		return KMOD_COMP_GZ;
+	else if (ends_with(".zst"))
+		return KMOD_COMP_ZSTD;
+
+	return KMOD_COMP_NONE;
+}
+
+
+/*
+ * Function to set up the decompression contexts of one thread
+ */
+inline void kmod_inflater_init(kmod_inflater_t& inf)
+{
+	lzma_stream xz_init = LZMA_STREAM_INIT;
+	inf.xz = xz_init;
+
+	// 15 + 32: gzip or zlib header with the largest window
+	memset(&inf.gz, 0, sizeof(inf.gz));
+	inf.gz_ready = inflateInit2(&inf.gz, 15 + 32) == Z_OK;
+
+#ifdef HAVE_ZSTD
+	inf.zst = ZSTD_createDCtx();
+#endif
+
+	inf.in.resize(KMOD_IN_CHUNK);
+	inf.out.reserve(KMOD_OUT_CHUNK);
+}
+
+
+/*
+ * Function to release the decompression contexts of one thread
+ */
+inline void kmod_inflater_exit(kmod_inflater_t& inf)
+{
+	lzma_end(&inf.xz);
+
+	if (inf.gz_ready)
+		inflateEnd(&inf.gz);
+
+#ifdef HAVE_ZSTD
+	ZSTD_freeDCtx(inf.zst);
+#endif
+}
+
+
+/*
+ * Function to restart the decompression context for the next module
+ * The contexts keep their memory, only their state is reset
+ */
+inline bool kmod_inflate_reset(kmod_inflater_t& inf, kmod_comp_t comp)
+{
+	inf.out.clear();
+
+	switch (comp)
+	{
+		case KMOD_COMP_XZ:
+			return lzma_stream_decoder(&inf.xz, UINT64_MAX, 0) == LZMA_OK;
+
+		case KMOD_COMP_GZ:
+			return inf.gz_ready && inflateReset(&inf.gz) == Z_OK;
+
+#ifdef HAVE_ZSTD
+		case KMOD_COMP_ZSTD:
+			return inf.zst != nullptr && !ZSTD_isError(ZSTD_DCtx_reset(inf.zst, ZSTD_reset_session_only));
+#endif
+
+		default:
+			return false;
+	}
+}
+
+
+/*
+ * Function to inflate up to one output chunk, appended to inf.out
+ * Returns false on corrupt data, finished is set at the end of the stream
+ */
+inline bool kmod_inflate(kmod_inflater_t& inf, kmod_comp_t comp,
+		const char*& next_in, size_t& avail_in, bool& finished)
+{
+	size_t old_size = inf.out.size();
+	inf.out.resize(old_size + KMOD_OUT_CHUNK);
+
+	char* next_out = &inf.out[old_size];
+	size_t avail_out = KMOD_OUT_CHUNK;
+	bool ok = false;
+
+	switch (comp)
+	{
+		case KMOD_COMP_XZ:
+		{
+			inf.xz.next_in = (const uint8_t*)next_in;
+			inf.xz.avail_in = avail_in;
+			inf.xz.next_out = (uint8_t*)next_out;
+			inf.xz.avail_out = avail_out;
+
+			lzma_ret ret = lzma_code(&inf.xz, LZMA_RUN);
+			finished = ret == LZMA_STREAM_END;
+			ok = ret == LZMA_OK || finished;
+
+			next_in = (const char*)inf.xz.next_in;
+			avail_in = inf.xz.avail_in;
+			avail_out = inf.xz.avail_out;
+			break;
+		}
+
+		case KMOD_COMP_GZ:
+		{
+			inf.gz.next_in = (Bytef*)next_in;
+			inf.gz.avail_in = avail_in;
+			inf.gz.next_out = (Bytef*)next_out;
+			inf.gz.avail_out = avail_out;
+
+			// Z_BUF_ERROR only means no progress was possible
+			int ret = inflate(&inf.gz, Z_NO_FLUSH);
+			finished = ret == Z_STREAM_END;
+			ok = ret == Z_OK || ret == Z_BUF_ERROR || finished;
+
+			next_in = (const char*)inf.gz.next_in;
+			avail_in = inf.gz.avail_in;
+			avail_out = inf.gz.avail_out;
+			break;
+		}
+
+#ifdef HAVE_ZSTD
+		case KMOD_COMP_ZSTD:
+		{
+			ZSTD_inBuffer in = {next_in, avail_in, 0};
+			ZSTD_outBuffer out = {next_out, avail_out, 0};
+
+			size_t ret = ZSTD_decompressStream(inf.zst, &out, &in);
+			finished = ret == 0;
+			ok = !ZSTD_isError(ret);
+
+			next_in += in.pos;
+			avail_in -= in.pos;
+			avail_out -= out.pos;
+			break;
+		}
+#endif
+
+		default:
+			break;
+	}
+
+	inf.out.resize(old_size + KMOD_OUT_CHUNK - avail_out);
+
+	return ok;
+}
+
+
+/*
+ * Function to read one compressed module
+ * The stream is inflated until the ELF header, the section headers and the
+ * sections they point to (section names, .modinfo) are all available, the
+ * same steps as for an uncompressed module. As the section headers come
+ * last, this is nearly the whole module.
+ */
+inline void kmod_read_compressed(kmod_file_t& kf, kmod_inflater_t& inf)
+{
+	kmod_comp_t comp = kmod_compression(kf.path);
+
+#ifndef HAVE_ZSTD
+	if (comp == KMOD_COMP_ZSTD)
+	{
+		kmod_fail(kf, "built without zstd support");
+		return;
+	}
+#endif
+
+	int fd = open(kf.path.c_str(), O_RDONLY | O_CLOEXEC);
+
+	if (fd < 0)
+	{
+		kmod_fail(kf, strerror(errno));
+		return;
+	}
+
+	if (!kmod_inflate_reset(inf, comp))
+	{
+		close(fd);
+		kmod_fail(kf, "cannot set up decompression");
+		return;
+	}
+
+	// the inflated size is unknown until the end of the stream
+	kf.size = KMOD_MAX_INFLATED;
+	kmod_advance(kf);
+
+	bool finished = false;
+
+	while (!finished && kf.step != KMOD_STEP_DONE)
+	{
+		ssize_t n = read(fd, &inf.in[0], inf.in.size());
+
+		if (n <= 0)
+		{
+			kmod_fail(kf, n < 0 ? strerror(errno) : "truncated compressed file");
+			break;
+		}
+
+		const char* next_in = inf.in.data();
+		size_t avail_in = n;
+		bool full = true;
+
+		// inflate this chunk, running every step whose data has arrived
+		while (!finished && kf.step != KMOD_STEP_DONE && (avail_in > 0 || full))
+		{
+			size_t old_size = inf.out.size();
+
+			if (!kmod_inflate(inf, comp, next_in, avail_in, finished))
+			{
+				kmod_fail(kf, "corrupt compressed data");
+				break;
+			}
+
+			full = inf.out.size() - old_size == KMOD_OUT_CHUNK;
+
+			while (kf.step != KMOD_STEP_DONE && kf.offset + kf.buf.size() <= inf.out.size())
+			{
+				kf.buf.assign(inf.out, kf.offset, kf.buf.size());
+				kmod_advance(kf);
+			}
+		}
+	}
+
+	close(fd);
+
+	if (kf.step != KMOD_STEP_DONE)
+		kmod_fail(kf, "truncated ELF file");
+
+	// do not hold on to the buffer of a large module
+	if (inf.out.capacity() > KMOD_OUT_KEEP)
+		std::string().swap(inf.out);
+}
+
+
+/*
+ * Function to read all modules on a pool of threads
+ */
+inline void kmod_read_threads(std::vector<kmod_file_t*> const& files, unsigned int jobs)
+{
+	std::atomic<size_t> next(0);
+
+	if (files.empty())
+		return;
+
+	auto worker = [&]()
+	{
+		// one set of decompression contexts per thread
+		kmod_inflater_t inf;
+		kmod_inflater_init(inf);
+
+		for (size_t i = next++; i < files.size(); i = next++)
+		{
+			if (kmod_compression(files[i]->path) == KMOD_COMP_NONE)
+				kmod_read_blocking(*files[i]);
+			else
+				kmod_read_compressed(*files[i], inf);
+		}
+
+		kmod_inflater_exit(inf);
+	};
+
+	std::vector<std::thread> threads;
+	jobs = std::min<size_t>(std::max(jobs, 1u), files.size());
+
+	for (unsigned int n = 1; n < jobs; n++)
+	{
+		threads.emplace_back(worker);
+	}
+
+	worker();
+
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+}
+
+
+// minimal io_uring without liburing
+typedef struct
+{
+	int fd;
+	unsigned int entries;
+	unsigned int* sq_head;
+	unsigned int* sq_tail;
+	unsigned int* sq_mask;
+	unsigned int* sq_array;
+	unsigned int* cq_head;
+	unsigned int* cq_tail;
+	unsigned int* cq_mask;
+	struct io_uring_sqe* sqes;
+	struct io_uring_cqe* cqes;
+	void* sq_ptr;
+	size_t sq_len;
+	void* cq_ptr;
+	size_t cq_len;
+	size_t sqes_len;
+} kmod_uring_t;
+
+
+/*
+ * Function to release the rings
+ */
+inline void kmod_uring_exit(kmod_uring_t& ring)
+{
+	if (ring.sqes != nullptr && ring.sqes != MAP_FAILED)
+		munmap(ring.sqes, ring.sqes_len);
+	if (ring.cq_ptr != nullptr && ring.cq_ptr != MAP_FAILED && ring.cq_ptr != ring.sq_ptr)
+		munmap(ring.cq_ptr, ring.cq_len);
+	if (ring.sq_ptr != nullptr && ring.sq_ptr != MAP_FAILED)
+		munmap(ring.sq_ptr, ring.sq_len);
+	if (ring.fd >= 0)
+		close(ring.fd);
+
+	ring.fd = -1;
+}
+
+
+/*
+ * Function to set up the rings, returns false if io_uring or one of the
+ * needed opcodes is unavailable
+ */
+inline bool kmod_uring_init(kmod_uring_t& ring, unsigned int entries)
+{
+	struct io_uring_params params;
+	memset(&params, 0, sizeof(params));
+	memset(&ring, 0, sizeof(ring));
+
+	ring.fd = syscall(__NR_io_uring_setup, entries, &params);
+
+	if (ring.fd < 0)
+		return false;
+
+	// check the opcodes, they need Linux 5.6 or later
+	std::vector<char> probe_buf(sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op), 0);
+	struct io_uring_probe* probe = (struct io_uring_probe*)probe_buf.data();
+
+	if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PROBE, probe, 256) < 0)
+	{
+		kmod_uring_exit(ring);
+		return false;
+	}
+
+	for (int op : {IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_READ, IORING_OP_CLOSE})
+	{
+		if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED))
+		{
+			kmod_uring_exit(ring);
+			return false;
+		}
+	}
+
+	ring.entries = params.sq_entries;
+	ring.sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+	ring.cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		ring.sq_len = ring.cq_len = std::max(ring.sq_len, ring.cq_len);
+
+	ring.sq_ptr = mmap(nullptr, ring.sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+			   ring.fd, IORING_OFF_SQ_RING);
+
+	if (ring.sq_ptr == MAP_FAILED)
+	{
+		kmod_uring_exit(ring);
+		return false;
+	}
+
+	if (params.features & IORING_FEAT_SINGLE_MMAP)
+		ring.cq_ptr = ring.sq_ptr;
+	else
+		ring.cq_ptr = mmap(nullptr, ring.cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+				   ring.fd, IORING_OFF_CQ_RING);
+
+	ring.sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+	ring.sqes = (struct io_uring_sqe*)mmap(nullptr, ring.sqes_len, PROT_READ | PROT_WRITE,
+					       MAP_SHARED | MAP_POPULATE, ring.fd, IORING_OFF_SQES);
+
+	if (ring.cq_ptr == MAP_FAILED || ring.sqes == MAP_FAILED)
+	{
+		kmod_uring_exit(ring);
+		return false;
+	}
+
+	char* sq = (char*)ring.sq_ptr;
+	char* cq = (char*)ring.cq_ptr;
+
+	ring.sq_head  = (unsigned int*)(sq + params.sq_off.head);
+	ring.sq_tail  = (unsigned int*)(sq + params.sq_off.tail);
+	ring.sq_mask  = (unsigned int*)(sq + params.sq_off.ring_mask);
+	ring.sq_array = (unsigned int*)(sq + params.sq_off.array);
+	ring.cq_head  = (unsigned int*)(cq + params.cq_off.head);
+	ring.cq_tail  = (unsigned int*)(cq + params.cq_off.tail);
+	ring.cq_mask  = (unsigned int*)(cq + params.cq_off.ring_mask);
+	ring.cqes     = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+	return true;
+}
+
+
+/*
+ * Function to queue one submission, returns the entry to fill in
+ */
+inline struct io_uring_sqe* kmod_uring_sqe(kmod_uring_t& ring, uint8_t opcode, uint64_t user_data)
+{
+	unsigned int tail = *ring.sq_tail;
+	unsigned int index = tail & *ring.sq_mask;
+	struct io_uring_sqe* sqe = &ring.sqes[index];
+
+	memset(sqe, 0, sizeof(*sqe));
+	sqe->opcode = opcode;
+	sqe->user_data = user_data;
+	ring.sq_array[index] = index;
+	__atomic_store_n(ring.sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+	return sqe;
+}
+
+
+/*
+ * Function to submit the queued entries and wait for all their completions
+ * complete() is called with the user_data and result of every completion
+ */
+template <typename F>
+inline bool kmod_uring_run(kmod_uring_t& ring, unsigned int count, F complete)
+{
+	unsigned int to_submit = count;
+	unsigned int done = 0;
+
+	while (done < count)
+	{
+		int ret = syscall(__NR_io_uring_enter, ring.fd, to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+		if (ret < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			return false;
+		}
+
+		to_submit -= std::min<unsigned int>(ret, to_submit);
+
+		unsigned int head = *ring.cq_head;
+		unsigned int tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+
+		for (; head != tail; head++, done++)
+		{
+			struct io_uring_cqe* cqe = &ring.cqes[head & *ring.cq_mask];
+			complete(cqe->user_data, cqe->res);
+		}
+
+		__atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+	}
+
+	return true;
+}
+
+
+/*
+ * Function to read all modules through io_uring, one batch per step
+ * Returns false if io_uring is unavailable, nothing has been read then
+ */
+inline bool kmod_read_uring(std::vector<kmod_file_t*> const& files)
+{
+	kmod_uring_t ring;
+
+	if (!kmod_uring_init(ring, 256))
+		return false;
+
+	// each module needs at most two entries per batch (openat + statx)
+	size_t batch = ring.entries / 2;
+	bool ok = true;
+
+	for (size_t start = 0; ok && start < files.size(); start += batch)
+	{
+		size_t end = std::min(files.size(), start + batch);
+
+		// open and statx the whole batch at once
+		unsigned int queued = 0;
+
+		for (size_t i = start; i < end; i++)
+		{
+			struct io_uring_sqe* sqe = kmod_uring_sqe(ring, IORING_OP_OPENAT, i * 2);
+			sqe->fd = AT_FDCWD;
+			sqe->addr = (uint64_t)files[i]->path.c_str();
+			sqe->open_flags = O_RDONLY | O_CLOEXEC;
+
+			sqe = kmod_uring_sqe(ring, IORING_OP_STATX, i * 2 + 1);
+			sqe->fd = AT_FDCWD;
+			sqe->addr = (uint64_t)files[i]->path.c_str();
+			sqe->len = STATX_SIZE;
+			sqe->off = (uint64_t)&files[i]->stx;
+
+			queued += 2;
+		}
+
+		ok = kmod_uring_run(ring, queued, [&](uint64_t user_data, int res)
+		{
+			kmod_file_t& kf = *files[user_data / 2];
+
+			if (res < 0)
+				kmod_fail(kf, strerror(-res));
+			else if (user_data % 2 == 0)
+				kf.fd = res;
+		});
+
+		for (size_t i = start; i < end; i++)
+		{
+			if (files[i]->step == KMOD_STEP_OPEN)
+			{
+				files[i]->size = files[i]->stx.stx_size;
+				kmod_advance(*files[i]);
+			}
+		}
+
+		// one batch of reads per step until every module is done
+		while (ok)
+		{
+			queued = 0;
+
+			for (size_t i = start; i < end; i++)
+			{
+				kmod_file_t& kf = *files[i];
+
+				if (kf.step == KMOD_STEP_DONE)
+					continue;
+
+				struct io_uring_sqe* sqe = kmod_uring_sqe(ring, IORING_OP_READ, i);
+				sqe->fd = kf.fd;
+				sqe->addr = (uint64_t)&kf.buf[0];
+				sqe->len = kf.buf.size();
+				sqe->off = kf.offset;
+				queued++;
+			}
+
+			if (queued == 0)
+				break;
+
+			ok = kmod_uring_run(ring, queued, [&](uint64_t user_data, int res)
+			{
+				kmod_file_t& kf = *files[user_data];
+
+				if (res < 0)
+					kmod_fail(kf, strerror(-res));
+				else if ((size_t)res != kf.buf.size())
+					kmod_fail(kf, "short read");
+				else
+					kmod_advance(kf);
+			});
+		}
+
+		// close the batch
+		queued = 0;
+
+		for (size_t i = start; i < end; i++)
+		{
+			if (files[i]->fd >= 0)
+			{
+				kmod_uring_sqe(ring, IORING_OP_CLOSE, i)->fd = files[i]->fd;
+				files[i]->fd = -1;
+				queued++;
+			}
+		}
+
+		ok = ok && kmod_uring_run(ring, queued, [](uint64_t, int) {});
+	}
+
+	kmod_uring_exit(ring);
+
+	return ok;
+}
+
+
+/*
+ * Function to read the .modinfo section of every module
+ * Uncompressed modules use io_uring when available, otherwise they join the
+ * compressed ones on the pool of jobs threads
+ */
+inline void kmod_read_modinfo(std::vector<kmod_file_t>& files, unsigned int jobs)
+{
+	std::vector<kmod_file_t*> plain, compressed;
+
+	for (auto& kf : files)
+	{
+		kf.step = KMOD_STEP_OPEN;
+		kf.fd = -1;
+		kf.size = 0;
+		kf.modinfo.clear();
+		kf.error.clear();
+
+		if (kmod_compression(kf.path) == KMOD_COMP_NONE)
+			plain.push_back(&kf);
+		else
+			compressed.push_back(&kf);
+	}
+
+	// inflate the compressed modules while io_uring reads the others
+	std::thread inflate_thread(kmod_read_threads, std::cref(compressed), jobs);
+
+	bool uring_ok = plain.empty() || kmod_read_uring(plain);
+
+	inflate_thread.join();
+
+	if (!uring_ok)
+	{
+		for (auto kf : plain)
+		{
+			if (kf->fd >= 0)
+				close(kf->fd);
+
+			kf->step = KMOD_STEP_OPEN;
+			kf->fd = -1;
+			kf->error.clear();
+		}
+
+		kmod_read_threads(plain, jobs);
+	}
+}
+
+
+/*
+ * Function to split the raw .modinfo data into (key, value) pairs
+ */
+inline std::vector<std::pair<std::string, std::string>> kmod_modinfo_fields(std::string const& modinfo)
+{
+	std::vector<std::pair<std::string, std::string>> fields;
+	size_t pos = 0;
+
+	while (pos < modinfo.size())
+	{
+		size_t end = modinfo.find('\0', pos);
+
+		if (end == std::string::npos)
+			end = modinfo.size();
+
+		size_t eq = modinfo.find('=', pos);
+
+		if (eq != std::string::npos && eq < end)
+			fields.emplace_back(modinfo.substr(pos, eq - pos), modinfo.substr(eq + 1, end - eq - 1));
+
+		pos = end + 1;
+	}
+
+	return fields;
+}
+
+#endif /* _KMODREADER_H */
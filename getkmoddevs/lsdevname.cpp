@@ -6,6 +6,10 @@
  *  For unknown vendors, it prints "UNKNOWN VENDOR <vendorID>"
  *  For unknown devices, it prints "UNKNOWN DEVICE <deviceID>"
  *
+ *  The inventory mode names every PCI and USB device found in sysfs.
+ *  With --format ndjson or tsv, every result is one record with explicit
+ *  found flags instead of the free-form text.
+ *
  *  Copyright (C) 2024-2025 Tuan Hoang <tqhoang@elrepo.org>
  *
  *  This program is free software; you can redistribute it and/or modify
@@ -25,10 +29,21 @@
 
 #include <algorithm>
 #include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <thread>
 #include <unordered_map>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 using namespace std;
 
@@ -49,14 +64,52 @@ const string TWO_SPACES("  ");
 typedef unordered_map<string, string> vendors_map_t;
 typedef unordered_map<string, unordered_map<string, string>> devices_map_t;
 
+// one vendor parsed by a worker thread, merged into the maps afterwards
+typedef struct
+{
+	string vendor_id;
+	string vendor_name;
+	unordered_map<string, string> devices;
+} ids_vendor_t;
+
+// below this size the ids file is always parsed by one thread
+const size_t IDS_CHUNK_MIN = 256 * 1024;
+
+// output formats
+typedef enum
+{
+	FORMAT_TEXT,
+	FORMAT_NDJSON,
+	FORMAT_TSV
+} output_format_t;
+
 // function prototypess
 void print_usage(char* progname);
-string str_tolower(string s);
+bool parse_hex_id(const char* str, int& id);
+string id_key(int id);
+string id_arg_key(const char* str);
 void parse_ids(string const& ids_file, vendors_map_t& vendors_map, devices_map_t& devices_map);
-void print_all_ids(vendors_map_t& vendors_map, devices_map_t& devices_map);
-void print_id(vendors_map_t& vendors_map, devices_map_t& devices_map,
-		string const& vendor_id, string const& device_id,
-		bool print_numbers, bool print_all);
+void parse_ids(string const& ids_file, vendors_map_t& vendors_map, devices_map_t& devices_map,
+		unsigned int jobs);
+bool is_vendor_line(string const& line);
+void parse_ids_chunk(const char* data, size_t begin, size_t end, vector<ids_vendor_t>& vendors);
+void print_all_ids(vendors_map_t const& vendors_map, devices_map_t const& devices_map,
+		string const& bus, output_format_t format, string& output);
+void print_id(vendors_map_t const& vendors_map, devices_map_t const& devices_map,
+		string const& bus, string const& vendor_key, string const& device_key,
+		bool print_numbers, bool print_all, output_format_t format, string& output);
+void lookup_id(vendors_map_t const& vendors_map, devices_map_t const& devices_map,
+		string const& vendor_key, string const& device_key,
+		const string*& vendor_name, const string*& device_name);
+void print_record(output_format_t format, string const& bus, string const& slot,
+		string const& vendor_key, const string* vendor_name,
+		string const& device_key, const string* device_name, string& output);
+void json_string(string const& str, string& output);
+bool read_sysfs_id(int dir_fd, const char* attr, string& id);
+bool print_inventory(string const& sysfs_root, string const& bus,
+		const char* vendor_attr, const char* device_attr,
+		vendors_map_t const& vendors_map, devices_map_t const& devices_map,
+		output_format_t format, bool required, string& output);
 
 
 /*
@@ -73,6 +126,12 @@ void print_usage(char* progname)
 	     << "-u,--usb             :  usb type device" << endl
 	     << "-a,--all             :  prints all devices" << endl
 	     << "-n,--numbers         :  prints device numbers" << endl
+	     << "-i,--inventory       :  prints all pci/usb devices found in sysfs" << endl
+	     << "-r,--sysfs-root <dir>:  sysfs root for the inventory (default /sys)" << endl
+	     << "-j,--jobs <n>        :  threads to parse the ids files for -i and full listings" << endl
+	     << "-f,--format <fmt>    :  text (default), ndjson or tsv" << endl
+	     << "                        tsv columns: bus slot vendor vendor_found vendor_name" << endl
+	     << "                                     device device_found device_name" << endl
 	     << "-h,--help            :  show help" << endl
 	     << endl;
 }
@@ -98,12 +157,17 @@ int main(int argc, char** argv)
 	int print_numbers = 0;
 	int type_pci = 0;
 	int type_usb = 0;
-	string vendor_id, device_id;
+	int inventory = 0;
+	string vendor_key;
+	string device_key;
+	output_format_t format = FORMAT_TEXT;
+	string sysfs_root = "/sys";
+	unsigned int jobs = thread::hardware_concurrency();
 	string pci_ids_file = "/usr/share/hwdata/pci.ids";
 	string usb_ids_file = "/usr/share/hwdata/usb.ids";
 
 
-	const char* const optstring = "v:d:puanh";
+	const char* const optstring = "v:d:puanir:j:f:h";
 	const option long_options[] = {
 		{"pcifile", required_argument, nullptr, 0},
 		{"usbfile", required_argument, nullptr, 0},
@@ -113,6 +177,10 @@ int main(int argc, char** argv)
 		{"usb", no_argument, nullptr, 'u'},
 		{"all", no_argument, nullptr, 'a'},
 		{"numbers", no_argument, nullptr, 'n'},
+		{"inventory", no_argument, nullptr, 'i'},
+		{"sysfs-root", required_argument, nullptr, 'r'},
+		{"jobs", required_argument, nullptr, 'j'},
+		{"format", required_argument, nullptr, 'f'},
 		{"help", no_argument, nullptr, 'h'},
 		{nullptr, no_argument, nullptr, 0}
 	};
@@ -143,11 +211,11 @@ int main(int argc, char** argv)
 				break;
 
 			case 'v':
-				vendor_id = optarg;
+				vendor_key = id_arg_key(optarg);
 				break;
 
 			case 'd':
-				device_id = optarg;
+				device_key = id_arg_key(optarg);
 				break;
 
 			case 'p':
@@ -166,6 +234,39 @@ int main(int argc, char** argv)
 				print_numbers = 1;
 				break;
 
+			case 'i':
+				inventory = 1;
+				break;
+
+			case 'r':
+				sysfs_root = optarg;
+				break;
+
+			case 'j':
+				jobs = atoi(optarg);
+				break;
+
+			case 'f':
+				optname = optarg;
+				if (optname == "text")
+				{
+					format = FORMAT_TEXT;
+				}
+				else if (optname == "ndjson" || optname == "json")
+				{
+					format = FORMAT_NDJSON;
+				}
+				else if (optname == "tsv")
+				{
+					format = FORMAT_TSV;
+				}
+				else
+				{
+					print_usage(prog_name);
+					return EXIT_FAILURE;
+				}
+				break;
+
 			case 'h': // -h or --help
 			case '?': // Unrecognized option
 			default:
@@ -174,6 +275,35 @@ int main(int argc, char** argv)
 		}
 	}
 
+	// inventory of the pci and/or usb devices, both by default
+	if (inventory)
+	{
+		string output;
+		bool ok = true;
+
+		if (type_pci || !type_usb)
+		{
+			parse_ids(pci_ids_file, vendors_map, devices_map, jobs);
+			ok = print_inventory(sysfs_root, "pci", "vendor", "device", vendors_map, devices_map,
+					     format, type_pci, output) && ok;
+		}
+
+		if (type_usb || !type_pci)
+		{
+			vendors_map_t usb_vendors_map;
+			devices_map_t usb_devices_map;
+
+			parse_ids(usb_ids_file, usb_vendors_map, usb_devices_map, jobs);
+			ok = print_inventory(sysfs_root, "usb", "idVendor", "idProduct", usb_vendors_map, usb_devices_map,
+					     format, type_usb, output) && ok;
+		}
+
+		cout << output;
+		cout.flush();
+
+		return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
 	// set default type
 	if ((!type_pci && !type_usb) || (type_pci && type_usb))
 	{
@@ -181,44 +311,101 @@ int main(int argc, char** argv)
 		type_usb = 0;
 	}
 	
+	// a single lookup does not need the threads
+	if (!vendor_key.empty())
+	{
+		jobs = 1;
+	}
+
 	// parse the hwdata ids files
 	if (type_pci)
 	{
-		parse_ids(pci_ids_file, vendors_map, devices_map);
+		parse_ids(pci_ids_file, vendors_map, devices_map, jobs);
 	}
 	else
 	{
-		parse_ids(usb_ids_file, vendors_map, devices_map);
+		parse_ids(usb_ids_file, vendors_map, devices_map, jobs);
 	}
 
-	// convert vendor_id and device_id to lowercase
-	vendor_id = str_tolower(vendor_id);
-	device_id = str_tolower(device_id);
-
 	// print the names
-	if (!vendor_id.empty())
+	string output;
+
+	if (!vendor_key.empty())
 	{
-		print_id(vendors_map, devices_map, vendor_id, device_id, print_numbers, print_all);
+		print_id(vendors_map, devices_map, type_pci ? "pci" : "usb", vendor_key, device_key,
+			 print_numbers, print_all, format, output);
 	}
 	else
 	{
-		print_all_ids(vendors_map, devices_map);
+		print_all_ids(vendors_map, devices_map, type_pci ? "pci" : "usb", format, output);
 	}
 
+	cout << output;
+	cout.flush();
+
 	return EXIT_SUCCESS;
 }
 
 
 /*
- * Function to convert a string to lowercase
- *
- * Reference: https://en.cppreference.com/w/cpp/string/byte/tolower
+ * Function to parse a hex id of 1 to 4 digits with an optional 0x prefix
  */
-string str_tolower(string s)
+bool parse_hex_id(const char* str, int& id)
 {
-	std::transform(s.begin(), s.end(), s.begin(),
+	int value = 0;
+	int digits = 0;
+
+	if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
+		str += 2;
+
+	for (; *str != '\0'; str++, digits++)
+	{
+		int c = std::tolower((unsigned char)*str);
+
+		if (digits == 4 || !std::isxdigit(c))
+			return false;
+
+		value = value * 16 + (std::isdigit(c) ? c - '0' : c - 'a' + 10);
+	}
+
+	if (digits == 0)
+		return false;
+
+	id = value;
+
+	return true;
+}
+
+
+/*
+ * Function to format an id the way the hwdata ids files do (4 lowercase hex digits)
+ */
+string id_key(int id)
+{
+	char key[8];
+	snprintf(key, sizeof(key), "%04x", id);
+
+	return key;
+}
+
+
+/*
+ * Function to turn a -v/-d argument into its ids-file key
+ * Anything that is not a hex id, such as the wildcards cut out of a
+ * modalias, is only lowercased and printed back as "UNKNOWN ..."
+ */
+string id_arg_key(const char* str)
+{
+	int id;
+
+	if (parse_hex_id(str, id))
+		return id_key(id);
+
+	string key = str;
+	transform(key.begin(), key.end(), key.begin(),
 			[](unsigned char c){ return std::tolower(c); });
-	return s;
+
+	return key;
 }
 
 
@@ -292,79 +479,497 @@ void parse_ids(string const& ids_file, vendors_map_t& vendors_map, devices_map_t
 
 
 /*
- * Function to print all hwdata ids
+ * Function to check if a line is a vendor line for parse_ids(): not a comment,
+ * not whitespace only, no tab and a two spaces delimiter
+ */
+bool is_vendor_line(string const& line)
+{
+	if (line[0] == '#' || line.find(ONE_TAB) != string::npos || line.find(TWO_SPACES) == string::npos)
+	{
+		return false;
+	}
+
+	return !std::all_of(line.begin(), line.end(), ::isspace);
+}
+
+
+/*
+ * Function to parse the lines in [begin, end) of an ids file, same rules as parse_ids()
+ * Device lines before the first vendor line of the chunk are dropped, this
+ * only happens at the start of the file
  */
-void print_all_ids(vendors_map_t& vendors_map, devices_map_t& devices_map)
+void parse_ids_chunk(const char* data, size_t begin, size_t end, vector<ids_vendor_t>& vendors)
 {
-	for (auto ven_iter : devices_map)
+	string line;
+
+	while (begin < end)
 	{
-		cout << ven_iter.first << TWO_SPACES << vendors_map[ven_iter.first] << endl;
+		const char* eol = (const char*)memchr(data + begin, '\n', end - begin);
+		size_t line_end = eol ? eol - data : end;
+
+		line.assign(data + begin, line_end - begin);
+		begin = line_end + 1;
 
-		for (auto dev_iter : ven_iter.second)
+		// skip comments or only whitespace lines
+		if (line[0] == '#' || std::all_of(line.begin(), line.end(), ::isspace))
+		{
+			continue;
+		}
+
+		if (line.find(TWO_TABS) != string::npos)
+		{
+			// ignore sub-vendor and sub-device info
+			continue;
+		}
+		else if (is_vendor_line(line))
 		{
-			cout << ONE_TAB << dev_iter.first << TWO_SPACES << dev_iter.second << endl;
+			size_t delim = line.find(TWO_SPACES);
+
+			vendors.emplace_back();
+			vendors.back().vendor_id   = line.substr(0, delim);
+			vendors.back().vendor_name = line.substr(delim + TWO_SPACES.length());
 		}
+		else if (line.find(ONE_TAB) != string::npos && !vendors.empty())
+		{
+			// device info
+			line = line.substr(line.find(ONE_TAB) + ONE_TAB.length());
 
-		cout << endl;
+			size_t delim = line.find(TWO_SPACES);
+			if (delim != string::npos)
+			{
+				vendors.back().devices[line.substr(0, delim)] = line.substr(delim + TWO_SPACES.length());
+			}
+		}
 	}
 }
 
 
 /*
- * Function to print one hwdata id
+ * Function to parse the hwdata ids files on several threads
+ *
+ * The mapped file is split at vendor lines, each chunk is parsed into its
+ * own list of vendors and the lists are merged in file order, giving the
+ * same maps as the sequential parser (a repeated vendor still replaces the
+ * earlier one). Small files and jobs <= 1 use the sequential parser.
  */
-void print_id(vendors_map_t& vendors_map, devices_map_t& devices_map,
-		string const& vendor_id, string const& device_id,
-		bool print_numbers, bool print_all)
+void parse_ids(string const& ids_file, vendors_map_t& vendors_map, devices_map_t& devices_map,
+		unsigned int jobs)
 {
-	string vendor_name, device_name;
+	int fd = open(ids_file.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat st;
 
-	if (vendors_map.find(vendor_id) != vendors_map.end())
+	if (fd < 0 || fstat(fd, &st) != 0 || jobs <= 1 || (size_t)st.st_size < IDS_CHUNK_MIN * 2)
 	{
-		vendor_name = vendors_map[vendor_id];
+		if (fd >= 0)
+			close(fd);
+
+		parse_ids(ids_file, vendors_map, devices_map);
+		return;
 	}
-	else
+
+	size_t size = st.st_size;
+	void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if (map == MAP_FAILED)
 	{
-		vendor_name = "UNKNOWN VENDOR " + vendor_id; 
+		parse_ids(ids_file, vendors_map, devices_map);
+		return;
 	}
 
-	if (!device_id.empty())
+	const char* data = (const char*)map;
+	jobs = std::min<size_t>(jobs, size / IDS_CHUNK_MIN);
+
+	// move every split point forward to the start of a vendor line
+	vector<size_t> bounds = {0};
+	string line;
+
+	for (unsigned int n = 1; n < jobs; n++)
 	{
-		if (devices_map[vendor_id].find(device_id) != devices_map[vendor_id].end())
+		size_t pos = std::max(bounds.back(), size * n / jobs);
+
+		// start of the next line
+		if (pos > 0 && data[pos - 1] != '\n')
 		{
-			device_name = devices_map[vendor_id][device_id];
+			const char* eol = (const char*)memchr(data + pos, '\n', size - pos);
+			pos = eol ? eol - data + 1 : size;
 		}
-		else
+
+		while (pos < size)
 		{
-			device_name = "UNKNOWN DEVICE " + device_id;
+			const char* eol = (const char*)memchr(data + pos, '\n', size - pos);
+			size_t line_end = eol ? eol - data : size;
+
+			line.assign(data + pos, line_end - pos);
+
+			if (is_vendor_line(line))
+				break;
+
+			pos = line_end + 1;
 		}
 
-		if (print_numbers)
-			cout << "[" << vendor_id << ":" << device_id << "]" << ONE_SPACE;
+		bounds.push_back(std::min(pos, size));
+	}
+
+	bounds.push_back(size);
 
-		cout << vendor_name << ONE_SPACE << device_name;
+	// parse the chunks
+	vector<vector<ids_vendor_t>> results(bounds.size() - 1);
+	vector<thread> threads;
+
+	for (size_t n = 1; n < results.size(); n++)
+	{
+		threads.emplace_back(parse_ids_chunk, data, bounds[n], bounds[n + 1], std::ref(results[n]));
 	}
-	else if (print_all)
+
+	parse_ids_chunk(data, bounds[0], bounds[1], results[0]);
+
+	for (auto& t : threads)
 	{
-		auto ven_iter = devices_map.find(vendor_id);
+		t.join();
+	}
+
+	munmap(map, size);
+
+	// merge in file order
+	for (auto& result : results)
+	{
+		for (auto& vendor : result)
+		{
+			vendors_map[vendor.vendor_id] = vendor.vendor_name;
+			devices_map[vendor.vendor_id] = std::move(vendor.devices);
+		}
+	}
+}
+
+
+/*
+ * Function to print all hwdata ids
+ */
+void print_all_ids(vendors_map_t const& vendors_map, devices_map_t const& devices_map,
+		string const& bus, output_format_t format, string& output)
+{
+	for (auto const& ven_iter : devices_map)
+	{
+		const string* vendor_name;
+		const string* device_name;
+
+		lookup_id(vendors_map, devices_map, ven_iter.first, "", vendor_name, device_name);
+
+		if (format != FORMAT_TEXT)
+		{
+			// one record per device, or one for a vendor without devices
+			if (ven_iter.second.empty())
+				print_record(format, bus, "", ven_iter.first, vendor_name, "", nullptr, output);
+
+			for (auto const& dev_iter : ven_iter.second)
+			{
+				print_record(format, bus, "", ven_iter.first, vendor_name,
+					     dev_iter.first, &dev_iter.second, output);
+			}
+
+			continue;
+		}
+
+		output += ven_iter.first + TWO_SPACES + (vendor_name ? *vendor_name : "") + "\n";
+
+		for (auto const& dev_iter : ven_iter.second)
+		{
+			output += ONE_TAB + dev_iter.first + TWO_SPACES + dev_iter.second + "\n";
+		}
+
+		output += "\n";
+	}
+}
+
+
+/*
+ * Function to print one hwdata id
+ */
+void print_id(vendors_map_t const& vendors_map, devices_map_t const& devices_map,
+		string const& bus, string const& vendor_key, string const& device_key,
+		bool print_numbers, bool print_all, output_format_t format, string& output)
+{
+	const string* vendor_name;
+	const string* device_name;
+
+	lookup_id(vendors_map, devices_map, vendor_key, device_key, vendor_name, device_name);
+
+	if (device_key.empty() && print_all)
+	{
+		auto ven_iter = devices_map.find(vendor_key);
 		if (ven_iter != devices_map.end())
 		{
-			for (auto dev_iter : ven_iter->second)
+			for (auto const& dev_iter : ven_iter->second)
 			{
+				if (format != FORMAT_TEXT)
+				{
+					print_record(format, bus, "", vendor_key, vendor_name,
+						     dev_iter.first, &dev_iter.second, output);
+					continue;
+				}
+
 				if (print_numbers)
-					cout << "[" << vendor_id << ":" << dev_iter.first << "]" << ONE_SPACE;
+					output += "[" + vendor_key + ":" + dev_iter.first + "]" + ONE_SPACE;
 
-				cout << vendors_map[ven_iter->first] << ONE_SPACE << dev_iter.second << endl;
+				output += *vendor_name + ONE_SPACE + dev_iter.second + "\n";
 			}
 		}
+		else if (format != FORMAT_TEXT)
+		{
+			print_record(format, bus, "", vendor_key, vendor_name, "", nullptr, output);
+		}
+
+		return;
+	}
+
+	if (format != FORMAT_TEXT)
+	{
+		print_record(format, bus, "", vendor_key, vendor_name, device_key, device_name, output);
+		return;
+	}
+
+	string vendor_text = vendor_name ? *vendor_name : "UNKNOWN VENDOR " + vendor_key;
+
+	if (!device_key.empty())
+	{
+		if (print_numbers)
+			output += "[" + vendor_key + ":" + device_key + "]" + ONE_SPACE;
+
+		output += vendor_text + ONE_SPACE + (device_name ? *device_name : "UNKNOWN DEVICE " + device_key);
 	}
 	else
 	{
 		if (print_numbers)
-			cout << "[" << vendor_id << ":****]" << ONE_SPACE;
+			output += "[" + vendor_key + ":****]" + ONE_SPACE;
 
-		cout << vendor_name;
+		output += vendor_text;
 	}
+}
 
-	cout.flush();
+
+/*
+ * Function to look up the names of an id without changing the maps
+ * The names are nullptr when not found, device_key may be empty
+ */
+void lookup_id(vendors_map_t const& vendors_map, devices_map_t const& devices_map,
+		string const& vendor_key, string const& device_key,
+		const string*& vendor_name, const string*& device_name)
+{
+	vendor_name = nullptr;
+	device_name = nullptr;
+
+	auto ven_iter = vendors_map.find(vendor_key);
+	if (ven_iter != vendors_map.end())
+	{
+		vendor_name = &ven_iter->second;
+	}
+
+	if (device_key.empty())
+		return;
+
+	auto devs_iter = devices_map.find(vendor_key);
+	if (devs_iter != devices_map.end())
+	{
+		auto dev_iter = devs_iter->second.find(device_key);
+		if (dev_iter != devs_iter->second.end())
+		{
+			device_name = &dev_iter->second;
+		}
+	}
+}
+
+
+/*
+ * Function to print one result as an NDJSON or TSV record
+ * An empty slot or device_key leaves out those fields
+ */
+void print_record(output_format_t format, string const& bus, string const& slot,
+		string const& vendor_key, const string* vendor_name,
+		string const& device_key, const string* device_name, string& output)
+{
+	if (format == FORMAT_TSV)
+	{
+		output += bus + ONE_TAB + slot + ONE_TAB + vendor_key + ONE_TAB
+			  + (vendor_name ? "1" : "0") + ONE_TAB + (vendor_name ? *vendor_name : "") + ONE_TAB
+			  + device_key + ONE_TAB;
+
+		if (!device_key.empty())
+			output += string(device_name ? "1" : "0") + ONE_TAB + (device_name ? *device_name : "");
+		else
+			output += ONE_TAB;
+
+		output += "\n";
+		return;
+	}
+
+	output += "{\"bus\":";
+	json_string(bus, output);
+
+	if (!slot.empty())
+	{
+		output += ",\"slot\":";
+		json_string(slot, output);
+	}
+
+	output += ",\"vendor\":";
+	json_string(vendor_key, output);
+	output += ",\"vendor_found\":";
+	output += vendor_name ? "true" : "false";
+
+	if (vendor_name)
+	{
+		output += ",\"vendor_name\":";
+		json_string(*vendor_name, output);
+	}
+
+	if (!device_key.empty())
+	{
+		output += ",\"device\":";
+		json_string(device_key, output);
+		output += ",\"device_found\":";
+		output += device_name ? "true" : "false";
+
+		if (device_name)
+		{
+			output += ",\"device_name\":";
+			json_string(*device_name, output);
+		}
+	}
+
+	output += "}\n";
+}
+
+
+/*
+ * Function to append a JSON string literal
+ */
+void json_string(string const& str, string& output)
+{
+	output += '"';
+
+	for (unsigned char c : str)
+	{
+		if (c == '"' || c == '\\')
+		{
+			output += '\\';
+			output += c;
+		}
+		else if (c < 0x20)
+		{
+			char esc[8];
+			snprintf(esc, sizeof(esc), "\\u%04x", c);
+			output += esc;
+		}
+		else
+		{
+			output += c;
+		}
+	}
+
+	output += '"';
+}
+
+
+/*
+ * Function to read a hex id from a sysfs attribute, as in the hwdata ids files
+ */
+bool read_sysfs_id(int dir_fd, const char* attr, string& id)
+{
+	char buf[32];
+	int fd = openat(dir_fd, attr, O_RDONLY | O_CLOEXEC);
+
+	if (fd < 0)
+		return false;
+
+	ssize_t len = read(fd, buf, sizeof(buf) - 1);
+	close(fd);
+
+	if (len <= 0)
+		return false;
+
+	buf[len] = '\0';
+
+	// pci has a "0x" prefix, usb does not
+	char* end = nullptr;
+	unsigned long value = strtoul(buf, &end, 16);
+
+	if (end == buf)
+		return false;
+
+	snprintf(buf, sizeof(buf), "%04lx", value);
+	id = buf;
+
+	return true;
+}
+
+
+/*
+ * Function to print the names of all devices of one sysfs bus
+ * Devices without ids (ex. usb interfaces) are skipped, and so is a
+ * missing bus unless it was asked for (required)
+ */
+bool print_inventory(string const& sysfs_root, string const& bus,
+		const char* vendor_attr, const char* device_attr,
+		vendors_map_t const& vendors_map, devices_map_t const& devices_map,
+		output_format_t format, bool required, string& output)
+{
+	string bus_devices = sysfs_root + "/bus/" + bus + "/devices";
+	DIR* dir = opendir(bus_devices.c_str());
+
+	if (dir == nullptr)
+	{
+		if (errno == ENOENT && !required)
+			return true;
+
+		cerr << "Error opening sysfs directory: " << bus_devices << endl;
+		return false;
+	}
+
+	vector<string> slots;
+	struct dirent* entry;
+
+	while ((entry = readdir(dir)) != nullptr)
+	{
+		if (entry->d_name[0] != '.')
+			slots.push_back(entry->d_name);
+	}
+
+	sort(slots.begin(), slots.end());
+
+	for (auto const& slot : slots)
+	{
+		int slot_fd = openat(dirfd(dir), slot.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+		if (slot_fd < 0)
+			continue;
+
+		string vendor_id, device_id;
+		bool found = read_sysfs_id(slot_fd, vendor_attr, vendor_id)
+			     && read_sysfs_id(slot_fd, device_attr, device_id);
+
+		close(slot_fd);
+
+		if (!found)
+			continue;
+
+		const string* vendor_name;
+		const string* device_name;
+
+		lookup_id(vendors_map, devices_map, vendor_id, device_id, vendor_name, device_name);
+
+		if (format != FORMAT_TEXT)
+		{
+			print_record(format, bus, slot, vendor_id, vendor_name, device_id, device_name, output);
+			continue;
+		}
+
+		output += slot + ONE_SPACE + "[" + vendor_id + ":" + device_id + "]" + ONE_SPACE
+			  + (vendor_name ? *vendor_name : "UNKNOWN VENDOR " + vendor_id) + ONE_SPACE
+			  + (device_name ? *device_name : "UNKNOWN DEVICE " + device_id) + "\n";
+	}
+
+	closedir(dir);
+
+	return true;
 }
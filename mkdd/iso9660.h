@@ -0,0 +1,656 @@
+/*
+ *  iso9660.h - Streaming ISO9660 + Rock Ridge image writer
+ *
+ *  Builds the same kind of image as 'mkisofs -lR' from an in-memory tree.
+ *  File data comes either from memory or from a file on disk, the whole
+ *  layout is computed up front and the image is then written strictly
+ *  sequentially, so the SHA256 of the image is computed as the bytes go out.
+ *
+ *  Copyright (C) 2026 The ELRepo Project <https://elrepo.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _ISO9660_H
+#define _ISO9660_H
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <openssl/evp.h>
+
+
+const uint32_t ISO_SECTOR_SIZE = 2048;
+const uint32_t ISO_SYSTEM_AREA_SECTORS = 16;
+const size_t ISO_MAX_RECORD_SIZE = 255;
+const size_t ISO_MAX_NAME_LENGTH = 30;   // mkisofs -l
+
+// Rock Ridge entries are kept inline (no SUSP continuation area), so the NM name
+// has to fit a record next to the longest identifier ("NAME.EXT;1" + padding)
+// and the RR, PX, TF and NM headers
+const size_t ISO_MAX_RR_NAME_LENGTH = ISO_MAX_RECORD_SIZE - 33 - (ISO_MAX_NAME_LENGTH + 3) - (5 + 36 + 26 + 5);
+
+
+// one file or directory of the image
+typedef struct iso_node
+{
+    std::string name;           // Rock Ridge name
+    std::string iso_name;       // ISO9660 file identifier
+    bool is_dir;
+    std::string data;           // file contents held in memory
+    std::string source_path;    // or file contents read from disk
+    uint64_t size;
+    uint32_t extent;
+    uint16_t dir_number;        // path table number
+    struct iso_node* parent;
+    std::vector<std::unique_ptr<struct iso_node>> children;
+} iso_node_t;
+
+
+// output stream that hashes everything written to it
+typedef struct
+{
+    std::ofstream out;
+    EVP_MD_CTX* sha256;
+    uint64_t written;
+} iso_stream_t;
+
+
+/*
+ * Functions to store both-endian and single-endian integers
+ */
+inline void iso_put_le16(unsigned char* p, uint16_t v)
+{
+    p[0] = v & 0xFF;
+    p[1] = v >> 8;
+}
+
+inline void iso_put_be16(unsigned char* p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+inline void iso_put_le32(unsigned char* p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[i] = (v >> (8 * i)) & 0xFF;
+}
+
+inline void iso_put_be32(unsigned char* p, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        p[3 - i] = (v >> (8 * i)) & 0xFF;
+}
+
+inline void iso_put_both16(unsigned char* p, uint16_t v)
+{
+    iso_put_le16(p, v);
+    iso_put_be16(p + 2, v);
+}
+
+inline void iso_put_both32(unsigned char* p, uint32_t v)
+{
+    iso_put_le32(p, v);
+    iso_put_be32(p + 4, v);
+}
+
+
+/*
+ * Function to round a byte count up to whole sectors
+ */
+inline uint32_t iso_sectors(uint64_t bytes)
+{
+    return (bytes + ISO_SECTOR_SIZE - 1) / ISO_SECTOR_SIZE;
+}
+
+
+/*
+ * Function to add a directory below parent
+ */
+inline iso_node_t* iso_add_dir(iso_node_t* parent, std::string const& name)
+{
+    parent->children.emplace_back(new iso_node_t{name, "", true, "", "", 0, 0, 0, parent, {}});
+    return parent->children.back().get();
+}
+
+
+/*
+ * Function to add a file held in memory below parent
+ */
+inline void iso_add_data(iso_node_t* parent, std::string const& name, std::string const& data)
+{
+    parent->children.emplace_back(new iso_node_t{name, "", false, data, "", data.size(), 0, 0, parent, {}});
+}
+
+
+/*
+ * Function to add a file read from disk below parent
+ */
+inline void iso_add_file(iso_node_t* parent, std::string const& name, std::string const& path, uint64_t size)
+{
+    parent->children.emplace_back(new iso_node_t{name, "", false, "", path, size, 0, 0, parent, {}});
+}
+
+
+/*
+ * Function to find a name below dir that is too long for a directory record
+ * Returns nullptr if all of the names fit
+ */
+inline iso_node_t const* iso_find_long_name(iso_node_t const* dir)
+{
+    for (auto const& child : dir->children)
+    {
+        if (child->name.size() > ISO_MAX_RR_NAME_LENGTH)
+        {
+            return child.get();
+        }
+
+        iso_node_t const* node = child->is_dir ? iso_find_long_name(child.get()) : nullptr;
+
+        if (node != nullptr)
+        {
+            return node;
+        }
+    }
+
+    return nullptr;
+}
+
+
+/*
+ * Function to build a unique ISO9660 identifier from a Rock Ridge name
+ * Files become "NAME.EXT;1", directories "NAME"
+ */
+inline std::string iso_make_name(std::string const& name, bool is_dir, std::set<std::string>& used)
+{
+    auto clean = [](std::string s)
+    {
+        for (auto& c : s)
+        {
+            c = isalnum((unsigned char)c) ? toupper((unsigned char)c) : '_';
+        }
+        return s;
+    };
+
+    std::string base = name, ext;
+    size_t dot = name.rfind('.');
+
+    if (!is_dir && dot != std::string::npos && dot > 0)
+    {
+        base = name.substr(0, dot);
+        ext  = clean(name.substr(dot + 1)).substr(0, 8);
+    }
+
+    base = clean(base);
+    size_t base_max = ISO_MAX_NAME_LENGTH - (is_dir ? 0 : ext.size() + 1);
+
+    for (int n = 0; ; n++)
+    {
+        std::string candidate = base.substr(0, base_max);
+
+        // replace the tail with a counter until the name is unique
+        if (n > 0)
+        {
+            std::string suffix = "_" + std::to_string(n);
+            candidate = candidate.substr(0, base_max - suffix.size()) + suffix;
+        }
+
+        std::string full = is_dir ? candidate : candidate + "." + ext + ";1";
+
+        if (used.insert(full).second)
+        {
+            return full;
+        }
+    }
+}
+
+
+/*
+ * Function to store a 7-byte directory record date
+ */
+inline void iso_put_dir_date(unsigned char* p, time_t t)
+{
+    struct tm tm;
+    gmtime_r(&t, &tm);
+
+    p[0] = tm.tm_year;
+    p[1] = tm.tm_mon + 1;
+    p[2] = tm.tm_mday;
+    p[3] = tm.tm_hour;
+    p[4] = tm.tm_min;
+    p[5] = tm.tm_sec;
+    p[6] = 0;
+}
+
+
+/*
+ * Function to store a 17-byte volume descriptor date
+ */
+inline void iso_put_vd_date(unsigned char* p, time_t t)
+{
+    struct tm tm;
+    char buf[32];
+
+    gmtime_r(&t, &tm);
+    strftime(buf, sizeof(buf), "%Y%m%d%H%M%S00", &tm);
+    memcpy(p, buf, 16);
+    p[16] = 0;
+}
+
+
+/*
+ * Function to build the Rock Ridge system use entries of a record
+ */
+inline std::string iso_rock_ridge(iso_node_t const* node, std::string const& rr_name, bool is_root_dot, time_t t)
+{
+    std::string su;
+    unsigned char buf[64];
+
+    if (is_root_dot)
+    {
+        // SP: SUSP indicator, only in the "." record of the root
+        const unsigned char sp[7] = {'S', 'P', 7, 1, 0xBE, 0xEF, 0};
+        su.append((const char*)sp, sizeof(sp));
+    }
+
+    // RR: which Rock Ridge entries follow (PX, NM, TF)
+    const unsigned char rr[5] = {'R', 'R', 5, 1, (unsigned char)(0x01 | (rr_name.empty() ? 0 : 0x08) | 0x80)};
+    su.append((const char*)rr, sizeof(rr));
+
+    // PX: POSIX mode, links, uid and gid
+    uint32_t nlink = 1;
+
+    if (node->is_dir)
+    {
+        nlink = 2;
+
+        for (auto const& child : node->children)
+        {
+            nlink += child->is_dir;
+        }
+    }
+
+    memset(buf, 0, sizeof(buf));
+    buf[0] = 'P';
+    buf[1] = 'X';
+    buf[2] = 36;
+    buf[3] = 1;
+    iso_put_both32(buf + 4, node->is_dir ? 040755 : 0100644);
+    iso_put_both32(buf + 12, nlink);
+    iso_put_both32(buf + 20, 0);
+    iso_put_both32(buf + 28, 0);
+    su.append((const char*)buf, 36);
+
+    // TF: modify, access and attribute change times
+    buf[0] = 'T';
+    buf[1] = 'F';
+    buf[2] = 5 + 3 * 7;
+    buf[3] = 1;
+    buf[4] = 0x0E;
+
+    for (int i = 0; i < 3; i++)
+    {
+        iso_put_dir_date(buf + 5 + i * 7, t);
+    }
+
+    su.append((const char*)buf, 5 + 3 * 7);
+
+    // NM: the real file name
+    if (!rr_name.empty())
+    {
+        const unsigned char nm[5] = {'N', 'M', (unsigned char)(5 + rr_name.size()), 1, 0};
+        su.append((const char*)nm, sizeof(nm));
+        su.append(rr_name);
+    }
+
+    if (is_root_dot)
+    {
+        // ER: extension reference for RRIP 1.09
+        const std::string id  = "RRIP_1991A";
+        const std::string des = "THE ROCK RIDGE INTERCHANGE PROTOCOL";
+        const std::string src = "ELREPO MKDD";
+        const unsigned char er[8] = {'E', 'R', (unsigned char)(8 + id.size() + des.size() + src.size()), 1,
+                                     (unsigned char)id.size(), (unsigned char)des.size(),
+                                     (unsigned char)src.size(), 1};
+        su.append((const char*)er, sizeof(er));
+        su += id + des + src;
+    }
+
+    return su;
+}
+
+
+/*
+ * Function to build one directory record
+ * identifier is "\0" for "." and "\1" for ".."
+ */
+inline std::string iso_dir_record(iso_node_t const* target, std::string const& identifier, std::string const& su,
+                                  time_t t)
+{
+    size_t len = 33 + identifier.size() + (identifier.size() % 2 == 0 ? 1 : 0) + su.size();
+
+    if (len > ISO_MAX_RECORD_SIZE)
+    {
+        return std::string();
+    }
+
+    std::string record(len, '\0');
+    unsigned char* p = (unsigned char*)&record[0];
+
+    p[0] = len;
+    iso_put_both32(p + 2, target->extent);
+    iso_put_both32(p + 10, target->size);
+    iso_put_dir_date(p + 18, t);
+    p[25] = target->is_dir ? 0x02 : 0x00;
+    iso_put_both16(p + 28, 1);
+    p[32] = identifier.size();
+    memcpy(p + 33, identifier.data(), identifier.size());
+    memcpy(p + len - su.size(), su.data(), su.size());
+
+    return record;
+}
+
+
+/*
+ * Function to build the records of a directory extent
+ * Records never cross a sector boundary, the extent is padded to whole sectors
+ */
+inline bool iso_dir_extent(iso_node_t const* dir, time_t t, std::string& extent)
+{
+    std::vector<std::string> records;
+    iso_node_t const* parent = dir->parent ? dir->parent : dir;
+
+    records.push_back(iso_dir_record(dir, std::string(1, '\0'), iso_rock_ridge(dir, "", dir->parent == nullptr, t), t));
+    records.push_back(iso_dir_record(parent, std::string(1, '\1'), iso_rock_ridge(parent, "", false, t), t));
+
+    for (auto const& child : dir->children)
+    {
+        records.push_back(iso_dir_record(child.get(), child->iso_name, iso_rock_ridge(child.get(), child->name, false, t), t));
+    }
+
+    extent.clear();
+
+    for (auto const& record : records)
+    {
+        if (record.empty())
+        {
+            return false;
+        }
+
+        size_t used = extent.size() % ISO_SECTOR_SIZE;
+
+        if (used + record.size() > ISO_SECTOR_SIZE)
+        {
+            extent.append(ISO_SECTOR_SIZE - used, '\0');
+        }
+
+        extent += record;
+    }
+
+    extent.append((ISO_SECTOR_SIZE - extent.size() % ISO_SECTOR_SIZE) % ISO_SECTOR_SIZE, '\0');
+
+    return true;
+}
+
+
+/*
+ * Function to build a path table, little endian (type L) or big endian (type M)
+ */
+inline std::string iso_path_table(std::vector<iso_node_t*> const& dirs, bool big_endian)
+{
+    std::string table;
+
+    for (auto const* dir : dirs)
+    {
+        std::string id = dir->parent ? dir->iso_name : std::string(1, '\0');
+        std::string entry(8 + id.size() + id.size() % 2, '\0');
+        unsigned char* p = (unsigned char*)&entry[0];
+        uint16_t parent_number = dir->parent ? dir->parent->dir_number : 1;
+
+        p[0] = id.size();
+
+        if (big_endian)
+        {
+            iso_put_be32(p + 2, dir->extent);
+            iso_put_be16(p + 6, parent_number);
+        }
+        else
+        {
+            iso_put_le32(p + 2, dir->extent);
+            iso_put_le16(p + 6, parent_number);
+        }
+
+        memcpy(p + 8, id.data(), id.size());
+        table += entry;
+    }
+
+    return table;
+}
+
+
+/*
+ * Function to write and hash bytes, optionally padding to the next sector
+ */
+inline bool iso_write(iso_stream_t& stream, const char* data, size_t len)
+{
+    stream.out.write(data, len);
+    EVP_DigestUpdate(stream.sha256, data, len);
+    stream.written += len;
+
+    return (bool)stream.out;
+}
+
+inline bool iso_pad(iso_stream_t& stream)
+{
+    static const char zeros[ISO_SECTOR_SIZE] = {0};
+    size_t pad = (ISO_SECTOR_SIZE - stream.written % ISO_SECTOR_SIZE) % ISO_SECTOR_SIZE;
+
+    return iso_write(stream, zeros, pad);
+}
+
+
+/*
+ * Function to write the image of the tree below root
+ * Returns false on error, sha256_hex receives the checksum of the image
+ */
+inline bool iso_write_image(iso_node_t& root, std::string const& volume_id, time_t t,
+                            std::string const& out_path, std::string& sha256_hex)
+{
+    // assign identifiers and sort, then list the directories in path table order
+    std::vector<iso_node_t*> dirs{&root};
+    std::vector<iso_node_t*> files;
+
+    for (size_t d = 0; d < dirs.size(); d++)
+    {
+        std::set<std::string> used;
+
+        for (auto& child : dirs[d]->children)
+        {
+            child->iso_name = iso_make_name(child->name, child->is_dir, used);
+        }
+
+        std::sort(dirs[d]->children.begin(), dirs[d]->children.end(),
+                  [](std::unique_ptr<iso_node_t> const& a, std::unique_ptr<iso_node_t> const& b)
+                  { return a->iso_name < b->iso_name; });
+
+        dirs[d]->dir_number = d + 1;
+
+        for (auto& child : dirs[d]->children)
+        {
+            if (child->is_dir)
+                dirs.push_back(child.get());
+            else
+                files.push_back(child.get());
+        }
+    }
+
+    // directory extent sizes do not depend on extent locations
+    std::string extent;
+
+    for (auto* dir : dirs)
+    {
+        if (!iso_dir_extent(dir, t, extent))
+        {
+            return false;
+        }
+
+        dir->size = extent.size();
+    }
+
+    // layout: system area, PVD, terminator, L and M path tables, directories, files
+    uint32_t path_table_size = iso_path_table(dirs, false).size();
+    uint32_t lba = ISO_SYSTEM_AREA_SECTORS + 2;
+    uint32_t l_table = lba;
+    lba += iso_sectors(path_table_size);
+    uint32_t m_table = lba;
+    lba += iso_sectors(path_table_size);
+
+    for (auto* dir : dirs)
+    {
+        dir->extent = lba;
+        lba += iso_sectors(dir->size);
+    }
+
+    for (auto* file : files)
+    {
+        file->extent = lba;
+        lba += iso_sectors(file->size);
+    }
+
+    uint32_t total_sectors = lba;
+
+    // stream the image out
+    iso_stream_t stream;
+    stream.out.open(out_path, std::ios::binary | std::ios::trunc);
+    stream.sha256 = EVP_MD_CTX_new();
+    stream.written = 0;
+
+    if (!stream.out || stream.sha256 == nullptr || !EVP_DigestInit_ex(stream.sha256, EVP_sha256(), nullptr))
+    {
+        EVP_MD_CTX_free(stream.sha256);
+        return false;
+    }
+
+    std::vector<char> sector(ISO_SECTOR_SIZE * ISO_SYSTEM_AREA_SECTORS, 0);
+    bool ok = iso_write(stream, sector.data(), sector.size());
+
+    // primary volume descriptor
+    unsigned char pvd[ISO_SECTOR_SIZE];
+    memset(pvd, 0, sizeof(pvd));
+    pvd[0] = 1;
+    memcpy(pvd + 1, "CD001", 5);
+    pvd[6] = 1;
+    memset(pvd + 8, ' ', 32);
+    memcpy(pvd + 8, "LINUX", 5);
+    memset(pvd + 40, ' ', 32);
+    memcpy(pvd + 40, volume_id.data(), std::min<size_t>(volume_id.size(), 32));
+    iso_put_both32(pvd + 80, total_sectors);
+    iso_put_both16(pvd + 120, 1);
+    iso_put_both16(pvd + 124, 1);
+    iso_put_both16(pvd + 128, ISO_SECTOR_SIZE);
+    iso_put_both32(pvd + 132, path_table_size);
+    iso_put_le32(pvd + 140, l_table);
+    iso_put_be32(pvd + 148, m_table);
+
+    std::string root_record = iso_dir_record(&root, std::string(1, '\0'), "", t);
+    memcpy(pvd + 156, root_record.data(), root_record.size());
+
+    memset(pvd + 190, ' ', 623);   // volume set .. bibliographic file identifiers
+    iso_put_vd_date(pvd + 813, t);
+    iso_put_vd_date(pvd + 830, t);
+    memset(pvd + 847, '0', 16);
+    iso_put_vd_date(pvd + 864, t);
+    pvd[881] = 1;
+    ok = ok && iso_write(stream, (const char*)pvd, sizeof(pvd));
+
+    // volume descriptor set terminator
+    unsigned char term[ISO_SECTOR_SIZE];
+    memset(term, 0, sizeof(term));
+    term[0] = 255;
+    memcpy(term + 1, "CD001", 5);
+    term[6] = 1;
+    ok = ok && iso_write(stream, (const char*)term, sizeof(term));
+
+    // path tables, now that the extents are known
+    std::string table = iso_path_table(dirs, false);
+    ok = ok && iso_write(stream, table.data(), table.size()) && iso_pad(stream);
+    table = iso_path_table(dirs, true);
+    ok = ok && iso_write(stream, table.data(), table.size()) && iso_pad(stream);
+
+    for (auto* dir : dirs)
+    {
+        ok = ok && iso_dir_extent(dir, t, extent) && iso_write(stream, extent.data(), extent.size());
+    }
+
+    // file data, disk files are copied in chunks
+    std::vector<char> chunk(1024 * 1024);
+
+    for (auto* file : files)
+    {
+        if (!ok)
+        {
+            break;
+        }
+
+        if (file->source_path.empty())
+        {
+            ok = iso_write(stream, file->data.data(), file->data.size());
+        }
+        else
+        {
+            std::ifstream in(file->source_path, std::ios::binary);
+            uint64_t left = file->size;
+
+            while (ok && left > 0)
+            {
+                size_t n = std::min<uint64_t>(left, chunk.size());
+                ok = (bool)in.read(chunk.data(), n) && iso_write(stream, chunk.data(), n);
+                left -= n;
+            }
+        }
+
+        ok = ok && iso_pad(stream);
+    }
+
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_len = 0;
+    EVP_DigestFinal_ex(stream.sha256, digest, &digest_len);
+    EVP_MD_CTX_free(stream.sha256);
+
+    sha256_hex.clear();
+
+    for (unsigned int i = 0; i < digest_len; i++)
+    {
+        char hex[3];
+        snprintf(hex, sizeof(hex), "%02x", digest[i]);
+        sha256_hex += hex;
+    }
+
+    stream.out.close();
+
+    return ok && stream.written == (uint64_t)total_sectors * ISO_SECTOR_SIZE && (bool)stream.out;
+}
+
+#endif /* _ISO9660_H */
@@ -0,0 +1,460 @@
+/*
+ *  mkdd - Creates Driver Update Disks for RHEL
+ *
+ *  Native replacement for mkdd.sh. For every kmod package the rhdd3
+ *  marker, the RPM, the SRPM and the generated repodata are written
+ *  straight into an ISO9660/Rock Ridge image (volume ID OEMDRV) and the
+ *  SHA256 is computed as the image is written. Every package is built in
+ *  its own in-memory workspace, so a whole release dir is built in
+ *  parallel. Signing stays an external gpg step over the *.SHA256SUM files.
+ *
+ *  Copyright (C) 2026 The ELRepo Project <https://elrepo.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "iso9660.h"
+#include "repodata.h"
+#include "rpmheader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+#include <dirent.h>
+#include <getopt.h>
+#include <sys/stat.h>
+extern char *optarg;
+extern int optind, opterr, optopt;
+
+
+// same exit codes as mkdd.sh
+typedef enum
+{
+    MKDD_OK             = 0,
+    MKDD_USAGE          = 1,
+    MKDD_NO_PACKAGE     = 2,
+    MKDD_NO_SOURCE      = 3,
+    MKDD_REPODATA_ERROR = 5,
+    MKDD_ISO_ERROR      = 6
+} mkdd_status_t;
+
+
+// DUD layout
+const string VOLUME_ID("OEMDRV");
+const string RHDD3_NAME("rhdd3");
+const string RHDD3_CONTENTS("Driver Update Disk version 3");
+const string RPMS_ARCH("x86_64");
+const string RPM_SUFFIX(".x86_64.rpm");
+const string SRPM_SUFFIX(".src.rpm");
+
+
+// one DUD to build, filled in by the worker threads
+typedef struct
+{
+    string kmod_rpm;
+    string iso_name;
+    mkdd_status_t status;
+    string messages;
+} dud_job_t;
+
+
+// globals
+string prog_name;
+
+
+// function prototypes
+void print_usage();
+bool file_exists(string const& path, struct stat* st = nullptr);
+string dir_name(string const& path);
+string base_name(string const& path);
+bool replace_suffix(string& s, string const& suffix, string const& replacement);
+string find_source_package(string const& kmod_rpm);
+vector<string> find_kmod_packages(string const& dir);
+mkdd_status_t build_dud(string const& kmod_rpm, string const& out_dir, time_t t, string& iso_name,
+                        ostream& messages);
+void build_all(vector<dud_job_t>& jobs_list, string const& out_dir, time_t t, unsigned int jobs);
+
+
+/*
+ * Main program
+ */
+int main(int argc, char** argv)
+{
+    prog_name = base_name(argv[0]);
+    string out_dir = ".";
+    unsigned int jobs = thread::hardware_concurrency();
+
+    const char* const optstring = "o:j:h";
+    const option longopts[] =
+    {
+        {"output", required_argument, nullptr, 'o'},
+        {"jobs", required_argument, nullptr, 'j'},
+        {"help", no_argument, nullptr, 'h'},
+        {nullptr, no_argument, nullptr, 0}
+    };
+    int longindex = 0;
+
+    while (true)
+    {
+        int c = getopt_long(argc, argv, optstring, longopts, &longindex);
+
+        if (c == -1)
+        {
+            break;
+        }
+
+        switch (c)
+        {
+            case 'o':
+                out_dir = optarg;
+                break;
+
+            case 'j':
+                jobs = atoi(optarg);
+                break;
+
+            case 'h': // -h or --help
+            case '?': // Unrecognized option
+            default:
+                print_usage();
+                return MKDD_USAGE;
+        }
+    }
+
+    if (optind >= argc)
+    {
+        print_usage();
+        return MKDD_USAGE;
+    }
+
+    if (jobs == 0)
+    {
+        jobs = 1;
+    }
+
+    // packages can be given one by one or as a release dir
+    vector<dud_job_t> jobs_list;
+
+    for (int i = optind; i < argc; i++)
+    {
+        struct stat st;
+        vector<string> kmods;
+
+        if (file_exists(argv[i], &st) && S_ISDIR(st.st_mode))
+            kmods = find_kmod_packages(argv[i]);
+        else
+            kmods.push_back(argv[i]);
+
+        for (auto const& kmod : kmods)
+        {
+            jobs_list.push_back({kmod, "", MKDD_OK, ""});
+        }
+    }
+
+    // honour SOURCE_DATE_EPOCH for reproducible images
+    time_t t = time(nullptr);
+    const char* sde = getenv("SOURCE_DATE_EPOCH");
+
+    if (sde != nullptr && *sde != '\0')
+    {
+        t = strtoll(sde, nullptr, 10);
+    }
+
+    build_all(jobs_list, out_dir, t, jobs);
+
+    // report in package order, the first failure sets the exit code
+    int status = MKDD_OK;
+
+    for (auto const& job : jobs_list)
+    {
+        cerr << job.messages;
+
+        if (job.status == MKDD_OK)
+        {
+            cout << job.iso_name << endl;
+        }
+        else if (status == MKDD_OK)
+        {
+            status = job.status;
+        }
+    }
+
+    return status;
+}
+
+
+// functions
+void print_usage()
+{
+    cerr << "Usage: " << prog_name << " [options] kmod-package|dir ..." << endl
+         << "-o,--output <dir>  :  output dir for the *.iso and *.SHA256SUM files (default .)" << endl
+         << "-j,--jobs <n>      :  number of DUDs built in parallel (default all cores)" << endl
+         << "-h,--help          :  show help" << endl
+         << endl;
+}
+
+
+bool file_exists(string const& path, struct stat* st)
+{
+    struct stat tmp;
+    return stat(path.c_str(), st ? st : &tmp) == 0;
+}
+
+
+string dir_name(string const& path)
+{
+    size_t slash = path.rfind('/');
+    return slash == string::npos ? string() : path.substr(0, slash + 1);
+}
+
+
+string base_name(string const& path)
+{
+    size_t slash = path.rfind('/');
+    return slash == string::npos ? path : path.substr(slash + 1);
+}
+
+
+bool replace_suffix(string& s, string const& suffix, string const& replacement)
+{
+    if (s.size() < suffix.size() || s.compare(s.size() - suffix.size(), suffix.size(), suffix) != 0)
+    {
+        return false;
+    }
+
+    s.replace(s.size() - suffix.size(), suffix.size(), replacement);
+    return true;
+}
+
+
+// finds the SRPM next to the kmod RPM, same naming rules as mkdd.sh
+// kmod-foo-1.0-1.el9.x86_64.rpm -> foo-kmod-1.0-1.el9.src.rpm or kmod-foo-1.0-1.el9.src.rpm
+string find_source_package(string const& kmod_rpm)
+{
+    string dir  = dir_name(kmod_rpm);
+    string name = base_name(kmod_rpm);
+
+    // second dash separated field, e.g. "foo"
+    size_t first_dash = name.find('-');
+    string ftwo;
+
+    if (first_dash != string::npos)
+    {
+        ftwo = name.substr(first_dash + 1, name.find('-', first_dash + 1) - first_dash - 1);
+    }
+
+    string srpm = name;
+
+    if (srpm.compare(0, 5, "kmod-") == 0)
+    {
+        srpm.replace(0, 5, ftwo + "-");
+    }
+
+    size_t pos = srpm.find("-" + ftwo);
+
+    if (!ftwo.empty() && pos != string::npos)
+    {
+        srpm.replace(pos, ftwo.size() + 1, "-kmod");
+    }
+
+    if (replace_suffix(srpm, RPM_SUFFIX, SRPM_SUFFIX) && file_exists(dir + srpm))
+    {
+        return dir + srpm;
+    }
+
+    srpm = name;
+
+    if (replace_suffix(srpm, RPM_SUFFIX, SRPM_SUFFIX) && file_exists(dir + srpm))
+    {
+        return dir + srpm;
+    }
+
+    return string();
+}
+
+
+// lists kmod-*.x86_64.rpm in a directory, sorted like 'ls'
+vector<string> find_kmod_packages(string const& dir)
+{
+    vector<string> kmods;
+    DIR* d = opendir(dir.c_str());
+
+    if (d == nullptr)
+    {
+        return kmods;
+    }
+
+    struct dirent* entry;
+
+    while ((entry = readdir(d)) != nullptr)
+    {
+        string name = entry->d_name;
+
+        if (name.compare(0, 5, "kmod-") == 0 && name.size() > RPM_SUFFIX.size()
+            && name.compare(name.size() - RPM_SUFFIX.size(), RPM_SUFFIX.size(), RPM_SUFFIX) == 0)
+        {
+            kmods.push_back(dir + "/" + name);
+        }
+    }
+
+    closedir(d);
+    sort(kmods.begin(), kmods.end());
+
+    return kmods;
+}
+
+
+// builds one DUD and its SHA256SUM file
+mkdd_status_t build_dud(string const& kmod_rpm, string const& out_dir, time_t t, string& iso_name,
+                        ostream& messages)
+{
+    struct stat rpm_st, srpm_st;
+
+    if (!file_exists(kmod_rpm, &rpm_st))
+    {
+        messages << prog_name << ": " << kmod_rpm << " -- no such package." << endl;
+        return MKDD_NO_PACKAGE;
+    }
+
+    string kmod_srpm = find_source_package(kmod_rpm);
+
+    if (kmod_srpm.empty() || !file_exists(kmod_srpm, &srpm_st))
+    {
+        messages << prog_name << ": The source package for " << kmod_rpm << " is not present." << endl;
+        return MKDD_NO_SOURCE;
+    }
+
+    // dd-foo-1.0-1.el9.iso
+    string pack_name = base_name(kmod_rpm);
+
+    if (pack_name.compare(0, 4, "kmod") == 0)
+    {
+        pack_name.replace(0, 4, "dd");
+    }
+
+    replace_suffix(pack_name, "x86_64.rpm", "iso");
+
+    // generate the repodata
+    repodata_package_t pkg;
+    repodata_files_t repodata;
+
+    pkg.file_name = base_name(kmod_rpm);
+    pkg.file_size = rpm_st.st_size;
+    pkg.file_time = rpm_st.st_mtime;
+    pkg.pkgid = repodata_sha256_file(kmod_rpm);
+
+    if (pkg.pkgid.empty() || !rpm_read_package(kmod_rpm, pkg.rpm) || !repodata_generate(pkg, t, repodata))
+    {
+        messages << prog_name << ": repodata generation has failed." << endl;
+        return MKDD_REPODATA_ERROR;
+    }
+
+    // populate the dd directory structure
+    iso_node_t root{"", "", true, "", "", 0, 0, 0, nullptr, {}};
+
+    iso_add_data(&root, RHDD3_NAME, RHDD3_CONTENTS);
+
+    iso_node_t* rpms_arch = iso_add_dir(iso_add_dir(&root, "rpms"), RPMS_ARCH);
+    iso_add_file(rpms_arch, base_name(kmod_rpm), kmod_rpm, rpm_st.st_size);
+
+    iso_node_t* repodata_dir = iso_add_dir(rpms_arch, "repodata");
+
+    for (auto const& file : repodata)
+    {
+        iso_add_data(repodata_dir, file.first, file.second);
+    }
+
+    iso_add_file(iso_add_dir(&root, "src"), base_name(kmod_srpm), kmod_srpm, srpm_st.st_size);
+
+    // the Rock Ridge names have to fit in the directory records
+    iso_node_t const* long_name = iso_find_long_name(&root);
+
+    if (long_name != nullptr)
+    {
+        messages << prog_name << ": " << long_name->name << " -- file name too long for the ISO image (max "
+                 << ISO_MAX_RR_NAME_LENGTH << " characters)." << endl;
+        return MKDD_ISO_ERROR;
+    }
+
+    // create the ISO9660 image
+    string iso_path = out_dir + "/" + pack_name;
+    string sha256;
+
+    if (!iso_write_image(root, VOLUME_ID, t, iso_path, sha256))
+    {
+        messages << prog_name << ": ISO image creation has failed." << endl;
+        remove(iso_path.c_str());
+        return MKDD_ISO_ERROR;
+    }
+
+    // create the file for gpg to sign, same format as sha256sum
+    string sha256_name = pack_name;
+    replace_suffix(sha256_name, "iso", "SHA256SUM");
+
+    ofstream sum(out_dir + "/" + sha256_name);
+    sum << sha256 << "  " << pack_name << endl;
+
+    if (!sum)
+    {
+        messages << prog_name << ": Writing " << sha256_name << " has failed." << endl;
+        return MKDD_ISO_ERROR;
+    }
+
+    iso_name = iso_path;
+
+    return MKDD_OK;
+}
+
+
+// builds all DUDs, each worker thread takes the next unbuilt package
+void build_all(vector<dud_job_t>& jobs_list, string const& out_dir, time_t t, unsigned int jobs)
+{
+    atomic<size_t> next(0);
+
+    auto worker = [&]()
+    {
+        for (size_t i = next++; i < jobs_list.size(); i = next++)
+        {
+            stringstream messages;
+            jobs_list[i].status = build_dud(jobs_list[i].kmod_rpm, out_dir, t, jobs_list[i].iso_name, messages);
+            jobs_list[i].messages = messages.str();
+        }
+    };
+
+    vector<thread> threads;
+    jobs = min<size_t>(jobs, jobs_list.size());
+
+    for (unsigned int n = 1; n < jobs; n++)
+    {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& thr : threads)
+    {
+        thr.join();
+    }
+}
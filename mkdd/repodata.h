@@ -0,0 +1,449 @@
+/*
+ *  repodata.h - Generates the yum/dnf repodata of a single package repo
+ *
+ *  Produces repomd.xml and the gzipped primary, filelists and other
+ *  metadata the same way 'createrepo -q' lays them out, straight from the
+ *  RPM header, so a Driver Update Disk needs no createrepo run or scratch
+ *  directory.
+ *
+ *  Copyright (C) 2026 The ELRepo Project <https://elrepo.org>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _REPODATA_H
+#define _REPODATA_H
+
+#include "rpmheader.h"
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <openssl/evp.h>
+#include <zlib.h>
+
+
+// repo metadata file name and contents
+typedef std::vector<std::pair<std::string, std::string>> repodata_files_t;
+
+
+// a package as needed by the metadata
+typedef struct
+{
+    std::string file_name;      // location href
+    std::string pkgid;          // sha256 of the whole package file
+    uint64_t file_size;
+    time_t file_time;
+    rpm_package_t rpm;
+} repodata_package_t;
+
+
+/*
+ * Function to format a sha256 digest as hex
+ */
+inline std::string repodata_hex(const unsigned char* digest, unsigned int len)
+{
+    std::string hex;
+    char buf[3];
+
+    for (unsigned int i = 0; i < len; i++)
+    {
+        snprintf(buf, sizeof(buf), "%02x", digest[i]);
+        hex += buf;
+    }
+
+    return hex;
+}
+
+
+/*
+ * Function to compute the sha256 of a string
+ */
+inline std::string repodata_sha256(std::string const& data)
+{
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+
+    EVP_Digest(data.data(), data.size(), digest, &len, EVP_sha256(), nullptr);
+
+    return repodata_hex(digest, len);
+}
+
+
+/*
+ * Function to compute the sha256 of a file, returns an empty string on error
+ */
+inline std::string repodata_sha256_file(std::string const& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+    std::vector<char> chunk(1024 * 1024);
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int len = 0;
+
+    if (!in || ctx == nullptr || !EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr))
+    {
+        EVP_MD_CTX_free(ctx);
+        return std::string();
+    }
+
+    while (in.read(chunk.data(), chunk.size()) || in.gcount() > 0)
+    {
+        EVP_DigestUpdate(ctx, chunk.data(), in.gcount());
+    }
+
+    EVP_DigestFinal_ex(ctx, digest, &len);
+    EVP_MD_CTX_free(ctx);
+
+    return repodata_hex(digest, len);
+}
+
+
+/*
+ * Function to gzip a string, the gzip header carries no name or timestamp
+ */
+inline bool repodata_gzip(std::string const& in, std::string& out)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        return false;
+    }
+
+    out.resize(deflateBound(&zs, in.size()));
+    zs.next_in   = (Bytef*)in.data();
+    zs.avail_in  = in.size();
+    zs.next_out  = (Bytef*)&out[0];
+    zs.avail_out = out.size();
+
+    int ret = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    return ret == Z_STREAM_END;
+}
+
+
+/*
+ * Function to escape XML text and attribute values
+ */
+inline std::string repodata_escape(std::string const& s)
+{
+    std::string out;
+    out.reserve(s.size());
+
+    for (char c : s)
+    {
+        switch (c)
+        {
+            case '&':  out += "&amp;";  break;
+            case '<':  out += "&lt;";   break;
+            case '>':  out += "&gt;";   break;
+            case '"':  out += "&quot;"; break;
+            default:   out += c;        break;
+        }
+    }
+
+    return out;
+}
+
+
+/*
+ * Function to split "[epoch:]version[-release]" into XML attributes
+ */
+inline std::string repodata_evr(std::string const& evr)
+{
+    std::string epoch = "0", version = evr, release;
+    size_t colon = version.find(':');
+
+    if (colon != std::string::npos)
+    {
+        epoch   = version.substr(0, colon);
+        version = version.substr(colon + 1);
+    }
+
+    size_t dash = version.rfind('-');
+
+    if (dash != std::string::npos)
+    {
+        release = version.substr(dash + 1);
+        version = version.substr(0, dash);
+    }
+
+    std::string attrs = " epoch=\"" + repodata_escape(epoch) + "\" ver=\"" + repodata_escape(version) + "\"";
+
+    if (!release.empty())
+    {
+        attrs += " rel=\"" + repodata_escape(release) + "\"";
+    }
+
+    return attrs;
+}
+
+
+/*
+ * Function to print one dependency list of the primary metadata
+ */
+inline void repodata_deps(std::ostream& xml, std::string const& element, std::vector<rpm_dep_t> const& deps,
+                          bool is_requires)
+{
+    std::set<std::string> seen;
+    std::stringstream entries;
+
+    for (auto const& dep : deps)
+    {
+        // rpmlib() requires are for rpm itself, not for the depsolver
+        if (is_requires && ((dep.flags & RPMSENSE_RPMLIB) || dep.name.compare(0, 7, "rpmlib(") == 0))
+        {
+            continue;
+        }
+
+        std::string entry = "      <rpm:entry name=\"" + repodata_escape(dep.name) + "\"";
+
+        if (!dep.version.empty())
+        {
+            const char* flags = "EQ";
+
+            switch (dep.flags & (RPMSENSE_LESS | RPMSENSE_GREATER | RPMSENSE_EQUAL))
+            {
+                case RPMSENSE_LESS:                    flags = "LT"; break;
+                case RPMSENSE_GREATER:                 flags = "GT"; break;
+                case RPMSENSE_LESS | RPMSENSE_EQUAL:    flags = "LE"; break;
+                case RPMSENSE_GREATER | RPMSENSE_EQUAL: flags = "GE"; break;
+                default:                               break;
+            }
+
+            entry += " flags=\"" + std::string(flags) + "\"" + repodata_evr(dep.version);
+        }
+
+        if (is_requires && (dep.flags & (RPMSENSE_PREREQ | RPMSENSE_SCRIPT_PRE | RPMSENSE_SCRIPT_POST)))
+        {
+            entry += " pre=\"1\"";
+        }
+
+        entry += "/>\n";
+
+        if (seen.insert(entry).second)
+        {
+            entries << entry;
+        }
+    }
+
+    if (!seen.empty())
+    {
+        xml << "    <rpm:" << element << ">\n" << entries.str() << "    </rpm:" << element << ">\n";
+    }
+}
+
+
+/*
+ * Function to print the <version .../> element of a package
+ */
+inline std::string repodata_version(rpm_header_t const& hdr)
+{
+    std::vector<uint64_t> epoch = rpm_get_ints(hdr, RPMTAG_EPOCH);
+
+    return "<version epoch=\"" + std::to_string(epoch.empty() ? 0 : epoch[0])
+           + "\" ver=\"" + repodata_escape(rpm_get_string(hdr, RPMTAG_VERSION))
+           + "\" rel=\"" + repodata_escape(rpm_get_string(hdr, RPMTAG_RELEASE)) + "\"/>";
+}
+
+
+/*
+ * Function to build primary.xml
+ */
+inline std::string repodata_primary(repodata_package_t const& pkg)
+{
+    rpm_header_t const& hdr = pkg.rpm.header;
+    std::stringstream xml;
+
+    uint64_t archive_size = rpm_get_int(hdr, RPMTAG_ARCHIVESIZE, rpm_get_int(pkg.rpm.signature, RPMSIGTAG_PAYLOADSIZE));
+
+    xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<metadata xmlns=\"http://linux.duke.edu/metadata/common\" "
+        << "xmlns:rpm=\"http://linux.duke.edu/metadata/rpm\" packages=\"1\">\n"
+        << "<package type=\"rpm\">\n"
+        << "  <name>" << repodata_escape(rpm_get_string(hdr, RPMTAG_NAME)) << "</name>\n"
+        << "  <arch>" << repodata_escape(rpm_get_string(hdr, RPMTAG_ARCH)) << "</arch>\n"
+        << "  " << repodata_version(hdr) << "\n"
+        << "  <checksum type=\"sha256\" pkgid=\"YES\">" << pkg.pkgid << "</checksum>\n"
+        << "  <summary>" << repodata_escape(rpm_get_string(hdr, RPMTAG_SUMMARY)) << "</summary>\n"
+        << "  <description>" << repodata_escape(rpm_get_string(hdr, RPMTAG_DESCRIPTION)) << "</description>\n"
+        << "  <packager>" << repodata_escape(rpm_get_string(hdr, RPMTAG_PACKAGER)) << "</packager>\n"
+        << "  <url>" << repodata_escape(rpm_get_string(hdr, RPMTAG_URL)) << "</url>\n"
+        << "  <time file=\"" << pkg.file_time << "\" build=\"" << rpm_get_int(hdr, RPMTAG_BUILDTIME) << "\"/>\n"
+        << "  <size package=\"" << pkg.file_size << "\" installed=\"" << rpm_get_int(hdr, RPMTAG_SIZE)
+        << "\" archive=\"" << archive_size << "\"/>\n"
+        << "  <location href=\"" << repodata_escape(pkg.file_name) << "\"/>\n"
+        << "  <format>\n"
+        << "    <rpm:license>" << repodata_escape(rpm_get_string(hdr, RPMTAG_LICENSE)) << "</rpm:license>\n"
+        << "    <rpm:vendor>" << repodata_escape(rpm_get_string(hdr, RPMTAG_VENDOR)) << "</rpm:vendor>\n"
+        << "    <rpm:group>" << repodata_escape(rpm_get_string(hdr, RPMTAG_GROUP)) << "</rpm:group>\n"
+        << "    <rpm:buildhost>" << repodata_escape(rpm_get_string(hdr, RPMTAG_BUILDHOST)) << "</rpm:buildhost>\n"
+        << "    <rpm:sourcerpm>" << repodata_escape(rpm_get_string(hdr, RPMTAG_SOURCERPM)) << "</rpm:sourcerpm>\n"
+        << "    <rpm:header-range start=\"" << pkg.rpm.header_offset
+        << "\" end=\"" << pkg.rpm.payload_offset << "\"/>\n";
+
+    repodata_deps(xml, "provides",
+                  rpm_get_deps(hdr, RPMTAG_PROVIDENAME, RPMTAG_PROVIDEFLAGS, RPMTAG_PROVIDEVERSION), false);
+    repodata_deps(xml, "requires",
+                  rpm_get_deps(hdr, RPMTAG_REQUIRENAME, RPMTAG_REQUIREFLAGS, RPMTAG_REQUIREVERSION), true);
+    repodata_deps(xml, "conflicts",
+                  rpm_get_deps(hdr, RPMTAG_CONFLICTNAME, RPMTAG_CONFLICTFLAGS, RPMTAG_CONFLICTVERSION), false);
+    repodata_deps(xml, "obsoletes",
+                  rpm_get_deps(hdr, RPMTAG_OBSOLETENAME, RPMTAG_OBSOLETEFLAGS, RPMTAG_OBSOLETEVERSION), false);
+
+    // primary only lists the files depsolvers commonly ask for
+    for (auto const& file : rpm_get_files(hdr))
+    {
+        if (file.path.compare(0, 5, "/etc/") == 0 || file.path.find("bin/") != std::string::npos
+            || file.path == "/usr/lib/sendmail")
+        {
+            xml << "    <file>" << repodata_escape(file.path) << "</file>\n";
+        }
+    }
+
+    xml << "  </format>\n"
+        << "</package>\n"
+        << "</metadata>\n";
+
+    return xml.str();
+}
+
+
+/*
+ * Function to build filelists.xml
+ */
+inline std::string repodata_filelists(repodata_package_t const& pkg)
+{
+    rpm_header_t const& hdr = pkg.rpm.header;
+    std::stringstream xml;
+
+    xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<filelists xmlns=\"http://linux.duke.edu/metadata/filelists\" packages=\"1\">\n"
+        << "<package pkgid=\"" << pkg.pkgid << "\" name=\"" << repodata_escape(rpm_get_string(hdr, RPMTAG_NAME))
+        << "\" arch=\"" << repodata_escape(rpm_get_string(hdr, RPMTAG_ARCH)) << "\">\n"
+        << "  " << repodata_version(hdr) << "\n";
+
+    for (auto const& file : rpm_get_files(hdr))
+    {
+        xml << "  <file";
+
+        if (file.flags & RPMFILE_GHOST)
+            xml << " type=\"ghost\"";
+        else if ((file.mode & 0170000) == 0040000)
+            xml << " type=\"dir\"";
+
+        xml << ">" << repodata_escape(file.path) << "</file>\n";
+    }
+
+    xml << "</package>\n"
+        << "</filelists>\n";
+
+    return xml.str();
+}
+
+
+/*
+ * Function to build other.xml
+ */
+inline std::string repodata_other(repodata_package_t const& pkg)
+{
+    rpm_header_t const& hdr = pkg.rpm.header;
+    std::vector<uint64_t> times    = rpm_get_ints(hdr, RPMTAG_CHANGELOGTIME);
+    std::vector<std::string> names = rpm_get_strings(hdr, RPMTAG_CHANGELOGNAME);
+    std::vector<std::string> texts = rpm_get_strings(hdr, RPMTAG_CHANGELOGTEXT);
+    std::stringstream xml;
+
+    xml << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<otherdata xmlns=\"http://linux.duke.edu/metadata/other\" packages=\"1\">\n"
+        << "<package pkgid=\"" << pkg.pkgid << "\" name=\"" << repodata_escape(rpm_get_string(hdr, RPMTAG_NAME))
+        << "\" arch=\"" << repodata_escape(rpm_get_string(hdr, RPMTAG_ARCH)) << "\">\n"
+        << "  " << repodata_version(hdr) << "\n";
+
+    for (size_t i = 0; i < times.size() && i < names.size() && i < texts.size(); i++)
+    {
+        xml << "  <changelog author=\"" << repodata_escape(names[i]) << "\" date=\"" << times[i] << "\">"
+            << repodata_escape(texts[i]) << "</changelog>\n";
+    }
+
+    xml << "</package>\n"
+        << "</otherdata>\n";
+
+    return xml.str();
+}
+
+
+/*
+ * Function to generate the repodata directory of a one package repo
+ * Returns false on error, files receives the name and contents of every file
+ */
+inline bool repodata_generate(repodata_package_t const& pkg, time_t t, repodata_files_t& files)
+{
+    const std::pair<const char*, std::string> metadata[] =
+    {
+        {"primary",   repodata_primary(pkg)},
+        {"filelists", repodata_filelists(pkg)},
+        {"other",     repodata_other(pkg)}
+    };
+
+    std::stringstream repomd;
+    repomd << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+           << "<repomd xmlns=\"http://linux.duke.edu/metadata/repo\" "
+           << "xmlns:rpm=\"http://linux.duke.edu/metadata/rpm\">\n"
+           << "  <revision>" << t << "</revision>\n";
+
+    files.clear();
+
+    for (auto const& md : metadata)
+    {
+        std::string gz;
+
+        if (!repodata_gzip(md.second, gz))
+        {
+            return false;
+        }
+
+        std::string checksum = repodata_sha256(gz);
+        std::string name = checksum + "-" + md.first + ".xml.gz";
+
+        repomd << "  <data type=\"" << md.first << "\">\n"
+               << "    <checksum type=\"sha256\">" << checksum << "</checksum>\n"
+               << "    <open-checksum type=\"sha256\">" << repodata_sha256(md.second) << "</open-checksum>\n"
+               << "    <location href=\"repodata/" << name << "\"/>\n"
+               << "    <timestamp>" << t << "</timestamp>\n"
+               << "    <size>" << gz.size() << "</size>\n"
+               << "    <open-size>" << md.second.size() << "</open-size>\n"
+               << "  </data>\n";
+
+        files.emplace_back(name, gz);
+    }
+
+    repomd << "</repomd>\n";
+    files.emplace_back("repomd.xml", repomd.str());
+
+    return true;
+}
+
+#endif /* _REPODATA_H */
@@ -21,6 +21,7 @@
 
 #include "json/json.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <iterator>
@@ -28,10 +29,14 @@
 #include <sstream>
 #include <string>
 #include <map>
+#include <vector>
 
 using namespace std;
 
+#include <dirent.h>
+#include <fcntl.h>
 #include <getopt.h>
+#include <unistd.h>
 extern char *optarg;
 extern int optind, opterr, optopt;
 
@@ -81,9 +86,31 @@ typedef struct
 typedef map<string, device_info_t> devices_map_t;
 
 
+// subdevice table entry, key is (devid << 16 | subdevid) and subdevid 0 matches any board
+typedef struct
+{
+    uint32_t key;
+    device_info_t info;
+} subdev_entry_t;
+
+// sorted by key, looked up with a binary search
+typedef vector<subdev_entry_t> subdev_table_t;
+
+// classifier table indexed directly by the 16-bit PCI device_id
+typedef vector<const device_info_t*> classify_table_t;
+
+
 // globals
 devices_map_t devices_map;
 devices_map_t::iterator devices_map_iter;
+vector<device_info_t> subdevices_list;
+subdev_table_t subdev_table;
+classify_table_t classify_table;
+
+
+// PCI ids used by the sysfs classifier
+const unsigned int PCI_VENDOR_ID_NVIDIA = 0x10de;
+const unsigned int PCI_BASE_CLASS_DISPLAY = 0x03;
 
 
 // legacy branch arrays and mappings
@@ -186,6 +213,14 @@ void inject_nvidia_device(string devid, string subdevid, string name, legacybran
 void print_text();
 void print_nvidia_detect();
 stringstream print_nvidia_devices(legacybranch_t legacybranch, kernelopen_t kernelopen);
+uint32_t pack_subdev_key(string const &devid, string const &subdevid);
+void build_subdev_table();
+const device_info_t* lookup_subdev(uint32_t key);
+stringstream print_nvidia_subdevices();
+void build_classify_table();
+const device_info_t* classify_device(unsigned int device, unsigned int subdevice);
+bool read_sysfs_hex(int dirfd, const char* attr, unsigned int &value);
+int classify_sysfs(string const &sysfs_root);
 
 
 /*
@@ -197,13 +232,17 @@ int main(int argc, char** argv)
     char* prog_name = argv[0];
     int print_txt = 0;
     int print_nv_detect = 1;
+    int classify = 0;
     string jsonFileName = "supported-gpus.json";
+    string sysfsRoot = "/sys";
 
-    const char* const optstring = "nth";
+    const char* const optstring = "ntcr:h";
     const option longopts[] =
     {
         {"nvidia-detect", no_argument, nullptr, 'n'},
         {"text", no_argument, nullptr, 't'},
+        {"classify", no_argument, nullptr, 'c'},
+        {"sysfs-root", required_argument, nullptr, 'r'},
         {"help", no_argument, nullptr, 'h'},
         {nullptr, no_argument, nullptr, 0}
     };
@@ -231,6 +270,14 @@ int main(int argc, char** argv)
                 print_nv_detect = 1;
                 break;
 
+            case 'c':
+                classify = 1;
+                break;
+
+            case 'r':
+                sysfsRoot = optarg;
+                break;
+
             case 0:
                 optname = longopts[longindex].name;
                 cerr << "Unhandled long_option: " << optname << endl;
@@ -303,6 +350,16 @@ int main(int argc, char** argv)
     inject_nvidia_device("0x20F0", "", "NVIDIA A100-PG506-207", LEGACYBRANCH_FALSE, KERNELOPEN_TRUE);
     inject_nvidia_device("0x20F2", "", "NVIDIA A100-PG506-217", LEGACYBRANCH_FALSE, KERNELOPEN_TRUE);
 
+    // build the (devid, subdevid) table from the final devices map
+    build_subdev_table();
+
+    // classify the GPUs found in sysfs
+    if (classify)
+    {
+        build_classify_table();
+        return classify_sysfs(sysfsRoot);
+    }
+
     // print deviceinfo data
     if (print_txt)
     {
@@ -323,6 +380,8 @@ void print_usage(char* progname)
     cerr << "Usage: " << progname << " [supported-gpus.json]" << endl
          << "-n,--nvidia-detect  :  output the nvidia-detect.h header file (default)" << endl
          << "-t,--text           :  output text dump of device info" << endl
+         << "-c,--classify       :  classify the NVIDIA GPUs found in sysfs" << endl
+         << "-r,--sysfs-root DIR :  sysfs root used by --classify (default /sys)" << endl
          << "-h,--help           :  show help" << endl
          << endl;
 }
@@ -361,12 +420,12 @@ string get_legacy_branch(legacybranch_t legacybranch)
 
 void parse_json(Json::Value const &root)
 {
-    device_info_t device_info;
-
     Json::Value chips = root["chips"];
 
     for (Json::Value::ArrayIndex i = 0; i != chips.size(); i++)
     {
+        device_info_t device_info = {"", "", "", LEGACYBRANCH_FALSE, KERNELOPEN_FALSE};
+
         if (chips[i].isMember("devid"))
         {
             device_info.devid = chips[i]["devid"].asString();
@@ -411,6 +470,12 @@ void parse_json(Json::Value const &root)
             }
         }
 
+        // keep every subdevid specific entry for the subdevice table
+        if (!device_info.subdevid.empty())
+        {
+            subdevices_list.push_back(device_info);
+        }
+
         // add the device info to the devices map
         devices_map_iter = devices_map.find(device_info.devid);
 
@@ -421,16 +486,10 @@ void parse_json(Json::Value const &root)
         else
         {
             // override the entry if the existing one has non-empty subdevid
-            // and the new one has an empty subdevid
+            // and the new one has an empty subdevid, the subdevid specific
+            // entry is still kept in subdevices_list
             if (!devices_map_iter->second.subdevid.empty() && device_info.subdevid.empty())
             {
-                cerr << "Replacing devid/subdevid = ("
-                     << devices_map_iter->second.devid << ","
-                     << devices_map_iter->second.subdevid << ") "
-                     << "with devid = ("
-                     << device_info.devid
-                     << ")" << endl;
-
                 devices_map_iter->second = device_info;
             }
         }
@@ -490,7 +549,8 @@ void print_nvidia_detect()
                   << "#ifndef _NVIDIA_DETECT_H" << endl
                   << "#define _NVIDIA_DETECT_H" << endl
                   << endl
-                  << "typedef unsigned short u_int16_t;" << endl;
+                  << "typedef unsigned short u_int16_t;" << endl
+                  << "typedef unsigned int u_int32_t;" << endl;
 
     stringstream nvidia_footer;
     nvidia_footer << "#endif /* _NVIDIA_DETECT_H */" << endl;
@@ -507,6 +567,7 @@ void print_nvidia_detect()
          << print_nvidia_devices(LEGACYBRANCH_580XX, KERNELOPEN_FALSE).str() << endl
          << print_nvidia_devices(LEGACYBRANCH_FALSE, KERNELOPEN_FALSE).str() << endl
          << print_nvidia_devices(LEGACYBRANCH_FALSE, KERNELOPEN_TRUE).str() << endl
+         << print_nvidia_subdevices().str() << endl
          << nvidia_footer.str() << endl;
 }
 
@@ -598,4 +659,294 @@ stringstream print_nvidia_devices(legacybranch_t legacybranch, kernelopen_t kern
     return nvidia_output;
 }
 
+// packs devid and subdevid strings such as "0x2204" into one 32-bit key
+uint32_t pack_subdev_key(string const &devid, string const &subdevid)
+{
+    uint32_t key = (stoul(devid, nullptr, 16) & 0xFFFF) << 16;
+
+    if (!subdevid.empty())
+    {
+        key |= stoul(subdevid, nullptr, 16) & 0xFFFF;
+    }
+
+    return key;
+}
+
+
+// builds the sorted (devid, subdevid) table
+// generic entries come from the devices map, specific ones from the JSON file
+void build_subdev_table()
+{
+    subdev_table.clear();
+    subdev_table.reserve(devices_map.size() + subdevices_list.size());
+
+    for (devices_map_iter  = devices_map.begin();
+         devices_map_iter != devices_map.end();
+         devices_map_iter++)
+    {
+        // only devids with an entry without subdevid match any board,
+        // the devices map keeps a subdevid specific entry otherwise
+        if (devices_map_iter->second.subdevid.empty())
+        {
+            subdev_table.push_back({pack_subdev_key(devices_map_iter->first, ""), devices_map_iter->second});
+        }
+    }
+
+    for (auto const &device_info : subdevices_list)
+    {
+        subdev_table.push_back({pack_subdev_key(device_info.devid, device_info.subdevid), device_info});
+    }
+
+    // keep the first entry for duplicate keys, generic entries were added first
+    stable_sort(subdev_table.begin(), subdev_table.end(),
+                [](subdev_entry_t const &a, subdev_entry_t const &b) { return a.key < b.key; });
+
+    subdev_table.erase(unique(subdev_table.begin(), subdev_table.end(),
+                              [](subdev_entry_t const &a, subdev_entry_t const &b) { return a.key == b.key; }),
+                       subdev_table.end());
+}
+
+
+// finds an exact key in the subdevice table, returns nullptr if missing
+const device_info_t* lookup_subdev(uint32_t key)
+{
+    auto iter = lower_bound(subdev_table.begin(), subdev_table.end(), key,
+                            [](subdev_entry_t const &entry, uint32_t k) { return entry.key < k; });
+
+    if (iter != subdev_table.end() && iter->key == key)
+    {
+        return &iter->info;
+    }
+
+    return nullptr;
+}
+
+
+// prints the subdevice table for the nvidia-detect header file
+stringstream print_nvidia_subdevices()
+{
+    const int device_row_limit = 8;
+    stringstream nvidia_output;
+    char hex[16];
+
+    nvidia_output << "/* Values of nv_subdev_pci_branches[], NV_BRANCH_OPEN is or'ed in for open driver devices */" << endl
+                  << "#define NV_BRANCH_CURRENT " << LEGACYBRANCH_FALSE << endl;
+
+    for (int b = LEGACYBRANCH_71XX; b < LEGACYBRANCH_UNKNOWN; b++)
+    {
+        // nv_71xx_pci_ids[] -> NV_BRANCH_71XX
+        string name = legacybranch_enum2array_map[(legacybranch_t)b];
+        name = name.substr(3, name.find("_pci_ids") - 3);
+        transform(name.begin(), name.end(), name.begin(), ::toupper);
+
+        nvidia_output << "#define NV_BRANCH_" << name << ONE_SPACE << b << endl;
+    }
+
+    nvidia_output << "#define NV_BRANCH_OPEN 0x80" << endl
+                  << endl
+                  << "/* PCI (device_id << 16 | subsystem_device_id) keys sorted ascending," << endl
+                  << " * look up the exact key first, then the generic key with subsystem_device_id 0 */" << endl
+                  << "static const u_int32_t nv_subdev_pci_ids[] = {";
+
+    for (size_t x = 0; x < subdev_table.size(); x++)
+    {
+        // insert tab before every row of devices
+        if (x % device_row_limit == 0)
+        {
+            nvidia_output << endl << ONE_TAB;
+        }
+        // otherwise insert a space before each device
+        else
+        {
+            nvidia_output << ONE_SPACE;
+        }
+
+        snprintf(hex, sizeof(hex), "0x%08X", subdev_table[x].key);
+        nvidia_output << hex << ",";
+    }
+
+    nvidia_output << endl << "};" << endl
+                  << endl
+                  << "static const unsigned char nv_subdev_pci_branches[] = {";
+
+    for (size_t x = 0; x < subdev_table.size(); x++)
+    {
+        if (x % device_row_limit == 0)
+        {
+            nvidia_output << endl << ONE_TAB;
+        }
+        else
+        {
+            nvidia_output << ONE_SPACE;
+        }
+
+        unsigned int flags = subdev_table[x].info.legacybranch;
+
+        if (subdev_table[x].info.legacybranch == LEGACYBRANCH_FALSE && subdev_table[x].info.kernelopen)
+        {
+            flags |= 0x80;
+        }
 
+        snprintf(hex, sizeof(hex), "0x%02X", flags);
+        nvidia_output << hex << ",";
+    }
+
+    nvidia_output << endl << "};" << endl;
+
+    return nvidia_output;
+}
+
+
+// builds the devid lookup table used by the sysfs classifier
+void build_classify_table()
+{
+    classify_table.assign(0x10000, nullptr);
+
+    for (devices_map_iter  = devices_map.begin();
+         devices_map_iter != devices_map.end();
+         devices_map_iter++)
+    {
+        unsigned long devid = stoul(devices_map_iter->first, nullptr, 16);
+
+        // same rule as the subdevice table, a devid only listed with
+        // subdevid specific entries does not match any board
+        if (devid <= 0xFFFF && devices_map_iter->second.subdevid.empty())
+        {
+            classify_table[devid] = &devices_map_iter->second;
+        }
+    }
+}
+
+
+// looks up a single PCI device, the subsystem specific entry wins over the generic one
+// returns nullptr if unsupported
+const device_info_t* classify_device(unsigned int device, unsigned int subdevice)
+{
+    if (subdevice != 0)
+    {
+        const device_info_t* info = lookup_subdev(((device & 0xFFFF) << 16) | (subdevice & 0xFFFF));
+
+        if (info != nullptr)
+        {
+            return info;
+        }
+    }
+
+    return classify_table[device & 0xFFFF];
+}
+
+
+// reads a hex attribute such as "0x10de" from a sysfs device directory
+bool read_sysfs_hex(int dirfd, const char* attr, unsigned int &value)
+{
+    char buf[32];
+    int fd = openat(dirfd, attr, O_RDONLY | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    ssize_t len = read(fd, buf, sizeof(buf) - 1);
+    close(fd);
+
+    if (len <= 0)
+    {
+        return false;
+    }
+
+    buf[len] = '\0';
+
+    char* end = nullptr;
+    value = strtoul(buf, &end, 16);
+
+    return end != buf;
+}
+
+
+// walks <sysfs_root>/bus/pci/devices and prints the driver for every NVIDIA GPU
+int classify_sysfs(string const &sysfs_root)
+{
+    string pci_devices = sysfs_root + "/bus/pci/devices";
+    DIR* dir = opendir(pci_devices.c_str());
+
+    if (dir == nullptr)
+    {
+        cerr << "Error opening sysfs directory: " << pci_devices << endl;
+        return EXIT_FAILURE;
+    }
+
+    vector<string> slots;
+    struct dirent* entry;
+
+    while ((entry = readdir(dir)) != nullptr)
+    {
+        if (entry->d_name[0] != '.')
+        {
+            slots.push_back(entry->d_name);
+        }
+    }
+
+    closedir(dir);
+    sort(slots.begin(), slots.end());
+
+    stringstream output;
+    int found = 0;
+
+    for (auto const &slot : slots)
+    {
+        string slot_path = pci_devices + "/" + slot;
+        int slot_fd = open(slot_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+        if (slot_fd < 0)
+        {
+            continue;
+        }
+
+        unsigned int vendor = 0, device = 0, subdevice = 0, pci_class = 0;
+        bool ok = read_sysfs_hex(slot_fd, "vendor", vendor)
+                  && read_sysfs_hex(slot_fd, "device", device)
+                  && read_sysfs_hex(slot_fd, "class", pci_class);
+
+        if (ok && vendor == PCI_VENDOR_ID_NVIDIA && (pci_class >> 16) == PCI_BASE_CLASS_DISPLAY)
+        {
+            read_sysfs_hex(slot_fd, "subsystem_device", subdevice);
+
+            char ids[32];
+            snprintf(ids, sizeof(ids), "[%04x:%04x:%04x]", vendor, device, subdevice);
+            output << slot << ONE_SPACE << ids << ONE_SPACE;
+
+            const device_info_t* info = classify_device(device, subdevice);
+
+            if (info == nullptr)
+            {
+                output << "UNSUPPORTED" << endl;
+            }
+            else if (info->legacybranch == LEGACYBRANCH_FALSE)
+            {
+                output << info->name
+                       << ": branch=current"
+                       << " module=" << (info->kernelopen ? "open" : "closed") << endl;
+            }
+            else
+            {
+                output << info->name
+                       << ": branch=" << legacybranch_enum2ver_map[info->legacybranch]
+                       << " module=closed" << endl;
+            }
+
+            found++;
+        }
+
+        close(slot_fd);
+    }
+
+    if (found == 0)
+    {
+        cerr << "No NVIDIA GPUs found in " << pci_devices << endl;
+    }
+
+    cout << output.str();
+
+    return EXIT_SUCCESS;
+}